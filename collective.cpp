@@ -117,6 +117,14 @@ void Collective::ConstructionInfo::serialize(Archive& ar, const unsigned int ver
 
 SERIALIZABLE(Collective::ConstructionInfo);
 
+template <class Archive>
+void Collective::MinionTaskState::serialize(Archive& ar, const unsigned int version) {
+  ar& BOOST_SERIALIZATION_NVP(chain)
+    & BOOST_SERIALIZATION_NVP(task);
+}
+
+SERIALIZABLE(Collective::MinionTaskState);
+
 template <class Archive>
 void Collective::GuardPostInfo::serialize(Archive& ar, const unsigned int version) {
   ar & BOOST_SERIALIZATION_NVP(attender);
@@ -429,7 +437,7 @@ void Collective::setMinionType(Creature* c, MinionType type) {
   removeElement(minionByType.at(getMinionType(c)), c);
   minionByType.at(type).push_back(c);
   if (!contains({MinionType::IMP, MinionType::BEAST}, type))
-    minionTasks.at(c->getUniqueId()) = getTasksForMinion(c);
+    minionTasks.at(c->getUniqueId()) = getInitialTasks(c);
 }
 
 struct TaskOption {
@@ -472,7 +480,7 @@ void Collective::getMinionOptions(Creature* c, vector<MinionOption>& mOpt, vecto
       lOpt = {"Possess", "Equipment", "Description" };
       lOpt.emplace_back("Order task:", View::TITLE);
       for (auto elem : taskOptions)
-        if (minionTasks.at(c->getUniqueId()).containsState(elem.task)) {
+        if (getTaskTransitions(minionTasks.at(c->getUniqueId()).chain).containsState(elem.task)) {
           lOpt.push_back(elem.description);
           mOpt.push_back(elem.option);
         }
@@ -502,11 +510,11 @@ void Collective::getMinionOptions(Creature* c, vector<MinionOption>& mOpt, vecto
 }
 
 void Collective::setMinionTask(Creature* c, MinionTask task) {
-  minionTasks.at(c->getUniqueId()).setState(task);
+  minionTasks.at(c->getUniqueId()).task = task;
 }
 
 MinionTask Collective::getMinionTask(Creature* c) const {
-  return minionTasks.at(c->getUniqueId()).getState();
+  return minionTasks.at(c->getUniqueId()).task;
 }
 
 void Collective::minionView(View* view, Creature* creature, int prevIndex) {
@@ -557,30 +565,97 @@ bool Collective::usesEquipment(const Creature* c) const {
   return c->isHumanoid() && getMinionType(c) != MinionType::PRISONER && c->getName() != "gnome";
 }
 
+void Collective::updateEquipmentIndex() {
+  const double refreshInterval = 10;
+  if (!equipmentIndex.dirty && equipmentIndex.numChanges == minionEquipment.getNumChanges()
+      && getTime() < equipmentIndex.lastUpdate + refreshInterval)
+    return;
+  for (auto& bucket : equipmentIndex.freeItems)
+    bucket.clear();
+  for (auto& elem : equipmentIndex.ownedItems)
+    elem.second.clear();
+  vector<Item*> freeWeapons;
+  auto addItem = [&] (Item* it, Vec2 pos, const Creature* carrier) {
+    if (Optional<MinionEquipment::EquipmentType> type = MinionEquipment::getEquipmentType(it)) {
+      EquipmentEntry entry {it->getUniqueId(), pos, carrier, minionEquipment.getItemValue(it)};
+      if (const Creature* owner = minionEquipment.getOwner(it))
+        equipmentIndex.ownedItems[owner].push_back(entry);
+      else if (!carrier) {
+        equipmentIndex.freeItems[*type].push_back(entry);
+        if (it->getType() == ItemType::WEAPON)
+          freeWeapons.push_back(it);
+      }
+    }
+  };
+  for (Vec2 v : myTiles)
+    for (Item* it : level->getSquare(v)->getItems())
+      addItem(it, v, nullptr);
+  for (Creature* c : creatures)
+    for (Item* it : c->getEquipment().getItems())
+      addItem(it, c->getPosition(), c);
+  auto byValue = [](const EquipmentEntry& e1, const EquipmentEntry& e2) {
+      if (e1.value == e2.value)
+        return e1.id < e2.id;
+      else
+        return e1.value > e2.value;
+  };
+  for (auto& bucket : equipmentIndex.freeItems)
+    sort(bucket.begin(), bucket.end(), byValue);
+  for (auto& elem : equipmentIndex.ownedItems)
+    sort(elem.second.begin(), elem.second.end(), byValue);
+  static PItem genWeapon = ItemFactory::fromId(ItemId::SWORD);
+  equipmentIndex.noWeapons = false;
+  for (Creature* c : minions)
+    if (usesEquipment(c) && c->canEquip(genWeapon.get()) && !std::any_of(freeWeapons.begin(), freeWeapons.end(),
+          [&] (const Item* it) { return minionEquipment.needs(c, it); })) {
+      equipmentIndex.noWeapons = true;
+      break;
+    }
+  equipmentIndex.dirty = false;
+  equipmentIndex.numChanges = minionEquipment.getNumChanges();
+  equipmentIndex.lastUpdate = getTime();
+}
+
+Item* Collective::getIndexedItem(const EquipmentEntry& entry) {
+  vector<Item*> items = entry.carrier ? entry.carrier->getEquipment().getItems()
+      : level->getSquare(entry.position)->getItems();
+  for (Item* it : items)
+    if (it->getUniqueId() == entry.id)
+      return it;
+  // the item was moved or destroyed without us noticing
+  equipmentIndex.dirty = true;
+  return nullptr;
+}
+
 void Collective::autoEquipment(Creature* creature, bool replace) {
+  updateEquipmentIndex();
   map<EquipmentSlot, Item*> slots;
-  vector<Item*> myItems = getAllItems([&](const Item* it) {
-      return minionEquipment.getOwner(it) == creature && it->canEquip(); });
-  for (Item* it : myItems) {
-    if (!slots.count(it->getEquipmentSlot())) {
-      slots[it->getEquipmentSlot()] = it;
-    } else  // a rare occurence that minion owns 2 items of the same slot,
-          //should happen only when an item leaves the fortress and then is braught back
-      minionEquipment.discard(it);
-  }
-  for (Item* it : getAllItems([&](const Item* it) {
-      return minionEquipment.needs(creature, it, false, replace) && !minionEquipment.getOwner(it); }, false)) {
-    if (!it->canEquip() || !slots.count(it->getEquipmentSlot())
-        || minionEquipment.getItemValue(slots.at(it->getEquipmentSlot())) < minionEquipment.getItemValue(it)) {
-      minionEquipment.own(creature, it);
-      if (it->canEquip() && slots.count(it->getEquipmentSlot()))
-        minionEquipment.discard(slots.at(it->getEquipmentSlot()));
-      if (it->canEquip())
-        slots[it->getEquipmentSlot()] = it;
-      if (it->getType() != ItemType::AMMO)
-        break;
+  if (equipmentIndex.ownedItems.count(creature))
+    for (const EquipmentEntry& entry : equipmentIndex.ownedItems.at(creature))
+      if (Item* it = getIndexedItem(entry))
+        if (it->canEquip() && minionEquipment.getOwner(it) == creature) {
+          if (!slots.count(it->getEquipmentSlot())) {
+            slots[it->getEquipmentSlot()] = it;
+          } else  // a rare occurence that minion owns 2 items of the same slot,
+                //should happen only when an item leaves the fortress and then is braught back
+            minionEquipment.discard(it);
+        }
+  for (auto& bucket : equipmentIndex.freeItems)
+    for (const EquipmentEntry& entry : bucket) {
+      Item* it = getIndexedItem(entry);
+      if (!it || !minionEquipment.needs(creature, it, false, replace) || minionEquipment.getOwner(it))
+        continue;
+      if (!it->canEquip() || !slots.count(it->getEquipmentSlot())
+          || minionEquipment.getItemValue(slots.at(it->getEquipmentSlot())) < minionEquipment.getItemValue(it)) {
+        minionEquipment.own(creature, it);
+        if (it->canEquip() && slots.count(it->getEquipmentSlot()))
+          minionEquipment.discard(slots.at(it->getEquipmentSlot()));
+        if (it->canEquip())
+          slots[it->getEquipmentSlot()] = it;
+        if (it->getType() != ItemType::AMMO)
+          return;
+      }
     }
-  }
 }
 
 void Collective::handleEquipment(View* view, Creature* creature, int prevItem) {
@@ -1150,7 +1225,8 @@ void Collective::refreshGameInfo(View::GameInfo& gameInfo) const {
         attacking = true;
     }
   if (attacking)
-    model->getView()->getJukebox()->setCurrent(Jukebox::BATTLE);
+    if (Jukebox* jukebox = model->getView()->getJukebox())
+      jukebox->setCurrent(Jukebox::BATTLE);
   Model::SunlightInfo sunlightInfo = model->getSunlightInfo();
   gameInfo.sunlightInfo = { sunlightInfo.getText(), (int)sunlightInfo.timeRemaining };
   gameInfo.infoType = View::GameInfo::InfoType::BAND;
@@ -1209,18 +1285,37 @@ void Collective::unmarkItem(UniqueId id) {
   markedItems.erase(id);
 }
 
+Collective::MemoryInfo::MemoryInfo(Rectangle bounds) : version(bounds, -1), lastSeen(bounds, -1) {
+}
+
+Collective::MemoryInfo& Collective::getMemoryInfo() {
+  // not serialized, after loading a game the memory is refreshed as tiles are seen again
+  if (!memoryInfo)
+    memoryInfo.reset(new MemoryInfo(level->getBounds()));
+  return *memoryInfo;
+}
+
 void Collective::updateMemory() {
-  for (Vec2 v : level->getBounds())
-    if (knownTiles[v])
-      addToMemory(v);
+  PROFILE("Collective::updateMemory");
+  MemoryInfo& info = getMemoryInfo();
+  int updateNum = ++info.numUpdates;
+  for (Creature* c : creatures)
+    if (c->getLevel() == level)
+      for (Vec2 pos : level->getVisibleTiles(c))
+        if (info.lastSeen[pos] != updateNum) {
+          info.lastSeen[pos] = updateNum;
+          addKnownTile(pos);
+          if (info.version[pos] != level->getSquare(pos)->getVersion())
+            addToMemory(pos);
+        }
 }
 
 const MapMemory& Collective::getMemory() const {
-  return (*memory.get())[level];
+  return MapMemory::getLevelMemory(*memory, level);
 }
 
 MapMemory& Collective::getMemory(Level* l) {
-  return (*memory.get())[l];
+  return MapMemory::getLevelMemory(*memory, l);
 }
 
 ViewObject Collective::getTrapObject(TrapType type) {
@@ -1264,6 +1359,26 @@ ViewIndex Collective::getViewIndex(Vec2 pos) const {
   return index;
 }
 
+int Collective::getViewIndexStamp(Vec2 pos) const {
+  int ret = 0;
+  if (taskMap.getMarked(pos))
+    ret |= 1;
+  else if (rectSelectCorner && rectSelectCorner2
+      && pos.inRectangle(Rectangle::boundingBox({*rectSelectCorner, *rectSelectCorner2})))
+    ret |= 2;
+  if (guardPosts.count(pos))
+    ret |= 4;
+  if (surprises.count(pos) && !knownPos(pos))
+    ret |= 8;
+  auto trap = traps.find(pos);
+  if (trap != traps.end())
+    ret |= (1 + int(trap->second.type)) << 4;
+  auto construction = constructions.find(pos);
+  if (construction != constructions.end() && !construction->second.built)
+    ret |= (1 + int(construction->second.type)) << 8;
+  return ret;
+}
+
 bool Collective::staticPosition() const {
   return false;
 }
@@ -1691,12 +1806,15 @@ void Collective::addKnownTile(Vec2 pos) {
     if (Task* task = taskMap.getMarked(pos))
       if (task->isImpossible(level))
         taskMap.removeTask(task);
+    addToMemory(pos);
   }
 }
 
 void Collective::onConstructed(Vec2 pos, SquareType type) {
-  if (!contains({SquareType::ANIMAL_TRAP, SquareType::TREE_TRUNK}, type))
+  if (!contains({SquareType::ANIMAL_TRAP, SquareType::TREE_TRUNK}, type)) {
     myTiles.insert(pos);
+    equipmentIndex.dirty = true;
+  }
   CHECK(!mySquares[type].count(pos));
   mySquares[type].insert(pos);
   if (contains({SquareType::FLOOR, SquareType::BRIDGE}, type))
@@ -1729,6 +1847,7 @@ void Collective::onCantPickItem(EntitySet items) {
 }
 
 void Collective::onBrought(Vec2 pos, vector<Item*> items) {
+  equipmentIndex.dirty = true;
 }
 
 void Collective::onAppliedItem(Vec2 pos, Item* item) {
@@ -1814,7 +1933,9 @@ ItemPredicate Collective::unMarkedItems(ItemType type) const {
 }
 
 void Collective::addToMemory(Vec2 pos) {
-  getMemory(level).update(pos, level->getSquare(pos)->getViewIndex(this));
+  const Square* square = level->getSquare(pos);
+  getMemory(level).update(pos, square->getViewIndex(this));
+  getMemoryInfo().version[pos] = square->getVersion();
 }
 
 void Collective::update(Creature* c) {
@@ -1834,10 +1955,6 @@ void Collective::update(Creature* c) {
       }
     }
   }
-  if (!contains(creatures, c) || c->getLevel() != level)
-    return;
-  for (Vec2 pos : level->getVisibleTiles(c))
-    addKnownTile(pos);
 }
 
 bool Collective::isDownstairsVisible() const {
@@ -1849,6 +1966,7 @@ bool Collective::isDownstairsVisible() const {
 const static int timeToBuild = 50;
 
 void Collective::updateConstructions() {
+  PROFILE("Collective::updateConstructions");
   map<TrapType, vector<pair<Item*, Vec2>>> trapItems;
   for (const BuildInfo& info : workshopInfo)
     if (info.buildType == BuildInfo::TRAP)
@@ -1910,13 +2028,16 @@ bool Collective::isDelayed(Vec2 pos) {
 }
 
 void Collective::tick() {
-  model->getView()->getJukebox()->update();
+  PROFILE("Collective::tick");
+  if (Jukebox* jukebox = model->getView()->getJukebox())
+    jukebox->update();
   if (retired) {
     if (const Creature* c = level->getPlayer())
       if (Random.roll(30) && !myTiles.count(c->getPosition()))
         c->playerMessage("You sense horrible evil in the " + 
             getCardinalName((keeper->getPosition() - c->getPosition()).getBearing().getCardinalDir()));
   }
+  updateMemory();
   updateVisibleCreatures();
   warning[int(Warning::MANA)] = mana < 100;
   warning[int(Warning::WOOD)] = numResource(ResourceId::WOOD) == 0;
@@ -1925,18 +2046,8 @@ void Collective::tick() {
   for (auto elem : taskInfo)
     if (!mySquares.at(elem.second.square).empty())
       warning[int(elem.second.warning)] = false;
-  warning[int(Warning::NO_WEAPONS)] = false;
-  PItem genWeapon = ItemFactory::fromId(ItemId::SWORD);
-  vector<Item*> freeWeapons = getAllItems([&](const Item* it) {
-      return it->getType() == ItemType::WEAPON && !minionEquipment.getOwner(it);
-    }, false);
-  for (Creature* c : minions) {
-    if (usesEquipment(c) && c->equip(genWeapon.get()) 
-        && filter(freeWeapons, [&] (const Item* it) { return minionEquipment.needs(c, it); }).empty()) {
-      warning[int(Warning::NO_WEAPONS)] = true;
-      break;
-    }
-  }
+  updateEquipmentIndex();
+  warning[int(Warning::NO_WEAPONS)] = equipmentIndex.noWeapons;
 
   map<Vec2, int> extendedTiles;
   queue<Vec2> extendedQueue;
@@ -2119,6 +2230,8 @@ void Collective::onTechBookEvent(Technology* tech) {
 void Collective::onEquipEvent(const Creature* c, const Item* it) {
   if (possessed == c)
     minionEquipment.own(c, it);
+  if (contains(creatures, c))
+    equipmentIndex.dirty = true;
 }
 
 void Collective::onPickupEvent(const Creature* c, const vector<Item*>& items) {
@@ -2126,6 +2239,18 @@ void Collective::onPickupEvent(const Creature* c, const vector<Item*>& items) {
     for (Item* it : items)
       if (minionEquipment.isItemUseful(it))
         minionEquipment.own(c, it);
+  if (contains(creatures, c) || myTiles.count(c->getPosition()))
+    equipmentIndex.dirty = true;
+}
+
+void Collective::onDropEvent(const Creature* c, const vector<Item*>& items) {
+  if (contains(creatures, c) || myTiles.count(c->getPosition()))
+    equipmentIndex.dirty = true;
+}
+
+void Collective::onItemsAppearedEvent(Vec2 position, const vector<Item*>& items) {
+  if (myTiles.count(position))
+    equipmentIndex.dirty = true;
 }
 
 void Collective::onSurrenderEvent(Creature* who, const Creature* to) {
@@ -2284,19 +2409,22 @@ MoveInfo Collective::getMinionMove(Creature* c) {
           return taskMap.getTask(c)->getMove(c);
         }
       }
-  minionTasks.at(c->getUniqueId()).update();
+  MinionTaskState& tasks = minionTasks.at(c->getUniqueId());
+  const MarkovChain<MinionTask>& transitions = getTaskTransitions(tasks.chain);
+  tasks.task = transitions.getNext(tasks.task);
   if (c->getHealth() < 1 && c->canSleep() && !c->isAffected(LastingEffect::POISON))
     for (MinionTask t : {MinionTask::SLEEP, MinionTask::GRAVE})
-      if (minionTasks.at(c->getUniqueId()).containsState(t)) {
-        minionTasks.at(c->getUniqueId()).setState(t);
+      if (transitions.containsState(t)) {
+        tasks.task = t;
         break;
       }
   if (c == keeper && !myTiles.empty() && !myTiles.count(c->getPosition()))
     if (auto action = c->moveTowards(chooseRandom(myTiles)))
       return {1.0, action};
-  MinionTaskInfo info = taskInfo.at(minionTasks.at(c->getUniqueId()).getState());
+  MinionTaskInfo info = taskInfo.at(tasks.task);
   if (mySquares[info.square].empty()) {
-    minionTasks.at(c->getUniqueId()).updateToNext();
+    if (auto next = transitions.getNextOther(tasks.task))
+      tasks.task = *next;
     warning[int(info.warning)] = true;
     return NoMove;
   }
@@ -2315,6 +2443,7 @@ bool Collective::underAttack() const {
 }
 
 Task* Collective::TaskMap::getTaskForImp(Creature* c) {
+  PROFILE("Collective::getTaskForImp");
   Task* closest = nullptr;
   for (PTask& task : tasks) {
     double dist = (task->getPosition() - c->getPosition()).length8();
@@ -2335,6 +2464,7 @@ Task* Collective::TaskMap::getTaskForImp(Creature* c) {
 }
 
 MoveInfo Collective::getMove(Creature* c) {
+  PROFILE("Collective::getMove");
   if (!contains(creatures, c))  // this is a creature from a vault that wasn't discovered yet
     return NoMove;
   if (!contains(minionByType.at(MinionType::IMP), c)) {
@@ -2368,46 +2498,66 @@ MoveInfo Collective::getMove(Creature* c) {
   }
 }
 
-MarkovChain<MinionTask> Collective::getTasksForMinion(Creature* c) {
+Collective::TaskChain Collective::getTaskChain(Creature* c) const {
   switch (getMinionType(c)) {
-    case MinionType::KEEPER:
-      return MarkovChain<MinionTask>(MinionTask::STUDY, {
-          {MinionTask::LABORATORY, {}},
-          {MinionTask::STUDY, {}},
-          {MinionTask::SLEEP, {{ MinionTask::STUDY, 1}}}});
-    case MinionType::PRISONER:
-      return MarkovChain<MinionTask>(MinionTask::PRISON, {
-          {MinionTask::PRISON, {}},
-          {MinionTask::TORTURE, {{ MinionTask::PRISON, 0.001}}}});
-    case MinionType::GOLEM:
-      return MarkovChain<MinionTask>(MinionTask::TRAIN, {{MinionTask::TRAIN, {}}});
+    case MinionType::KEEPER: return TaskChain::KEEPER;
+    case MinionType::PRISONER: return TaskChain::PRISONER;
+    case MinionType::GOLEM: return TaskChain::GOLEM;
     case MinionType::UNDEAD:
       if (c->getName() != "vampire lord")
-        return MarkovChain<MinionTask>(MinionTask::GRAVE, {
-            {MinionTask::GRAVE, {{ MinionTask::TRAIN, 0.5}}},
-            {MinionTask::TRAIN, {{ MinionTask::GRAVE, 0.005}}}});
+        return TaskChain::UNDEAD;
       else
-        return MarkovChain<MinionTask>(MinionTask::GRAVE, {
-            {MinionTask::GRAVE, {{ MinionTask::TRAIN, 0.5}, { MinionTask::STUDY, 0.1}}},
-            {MinionTask::STUDY, {{ MinionTask::GRAVE, 0.005}}},
-            {MinionTask::TRAIN, {{ MinionTask::GRAVE, 0.005}}}});
-    case MinionType::NORMAL: {
-      double workshopTime = (c->getName() == "gnome" ? 0.65 : 0.2);
-      double labTime = (c->getName() == "gnome" ? 0.35 : 0.1);
-      double trainTime = 1 - workshopTime - labTime;
-      double changeFreq = 0.01;
-      return MarkovChain<MinionTask>(MinionTask::SLEEP, {
-          {MinionTask::SLEEP, {{ MinionTask::TRAIN, trainTime}, { MinionTask::WORKSHOP, workshopTime},
-          {MinionTask::LABORATORY, labTime}}},
-          {MinionTask::WORKSHOP, {{ MinionTask::SLEEP, changeFreq}}},
-          {MinionTask::LABORATORY, {{ MinionTask::SLEEP, changeFreq}}},
-          {MinionTask::TRAIN, {{ MinionTask::SLEEP, changeFreq}}}});
-      }
+        return TaskChain::VAMPIRE_LORD;
+    case MinionType::NORMAL:
+      if (c->getName() == "gnome")
+        return TaskChain::GNOME;
+      else
+        return TaskChain::NORMAL;
     case MinionType::BEAST:
     case MinionType::IMP: FAIL << "Not handled by this method";
   }
   FAIL <<"pokewf";
-  return MarkovChain<MinionTask>(MinionTask::TRAIN, {{MinionTask::TRAIN, {}}});
+  return TaskChain::GOLEM;
+}
+
+static MarkovChain<MinionTask> getWorkerTransitions(double workshopTime, double labTime) {
+  double trainTime = 1 - workshopTime - labTime;
+  double changeFreq = 0.01;
+  return MarkovChain<MinionTask>(MinionTask::SLEEP, {
+      {MinionTask::SLEEP, {{ MinionTask::TRAIN, trainTime}, { MinionTask::WORKSHOP, workshopTime},
+      {MinionTask::LABORATORY, labTime}}},
+      {MinionTask::WORKSHOP, {{ MinionTask::SLEEP, changeFreq}}},
+      {MinionTask::LABORATORY, {{ MinionTask::SLEEP, changeFreq}}},
+      {MinionTask::TRAIN, {{ MinionTask::SLEEP, changeFreq}}}});
+}
+
+const MarkovChain<MinionTask>& Collective::getTaskTransitions(TaskChain chain) {
+  // Indexed by TaskChain.
+  static vector<MarkovChain<MinionTask>> transitions {
+    MarkovChain<MinionTask>(MinionTask::STUDY, {
+        {MinionTask::LABORATORY, {}},
+        {MinionTask::STUDY, {}},
+        {MinionTask::SLEEP, {{ MinionTask::STUDY, 1}}}}),
+    MarkovChain<MinionTask>(MinionTask::PRISON, {
+        {MinionTask::PRISON, {}},
+        {MinionTask::TORTURE, {{ MinionTask::PRISON, 0.001}}}}),
+    MarkovChain<MinionTask>(MinionTask::TRAIN, {{MinionTask::TRAIN, {}}}),
+    MarkovChain<MinionTask>(MinionTask::GRAVE, {
+        {MinionTask::GRAVE, {{ MinionTask::TRAIN, 0.5}}},
+        {MinionTask::TRAIN, {{ MinionTask::GRAVE, 0.005}}}}),
+    MarkovChain<MinionTask>(MinionTask::GRAVE, {
+        {MinionTask::GRAVE, {{ MinionTask::TRAIN, 0.5}, { MinionTask::STUDY, 0.1}}},
+        {MinionTask::STUDY, {{ MinionTask::GRAVE, 0.005}}},
+        {MinionTask::TRAIN, {{ MinionTask::GRAVE, 0.005}}}}),
+    getWorkerTransitions(0.65, 0.35),
+    getWorkerTransitions(0.2, 0.1),
+  };
+  return transitions.at(int(chain));
+}
+
+Collective::MinionTaskState Collective::getInitialTasks(Creature* c) const {
+  TaskChain chain = getTaskChain(c);
+  return {chain, getTaskTransitions(chain).getInitialState()};
 }
 
 Creature* Collective::addCreature(PCreature creature, Vec2 v, MinionType type) {
@@ -2441,6 +2591,7 @@ void Collective::addCreature(Creature* c, MinionType type) {
   else
     c->addSectors(flyingSectors.get());
   creatures.push_back(c);
+  equipmentIndex.dirty = true;
   minionByType[type].push_back(c);
   if (!contains({MinionType::IMP}, type)) {
     minions.push_back(c);
@@ -2449,7 +2600,7 @@ void Collective::addCreature(Creature* c, MinionType type) {
         c->addSkill(skill);
   }
   if (!contains({MinionType::BEAST, MinionType::IMP}, type))
-    minionTasks.insert(make_pair(c->getUniqueId(), getTasksForMinion(c)));
+    minionTasks.insert(make_pair(c->getUniqueId(), getInitialTasks(c)));
   for (const Item* item : c->getEquipment().getItems())
     minionEquipment.own(c, item);
   if (type == MinionType::PRISONER)
@@ -2534,6 +2685,7 @@ void Collective::onKillEvent(const Creature* victim, const Creature* killer) {
   if (contains(creatures, victim)) {
     Creature* c = const_cast<Creature*>(victim);
     removeElement(creatures, c);
+    equipmentIndex.dirty = true;
     if (getMinionType(victim) == MinionType::PRISONER && killer && contains(creatures, killer))
       ++executions;
     prisonerInfo.erase(c);
@@ -47,6 +47,7 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
   virtual const MapMemory& getMemory() const override;
   MapMemory& getMemory(Level* l);
   virtual ViewIndex getViewIndex(Vec2 pos) const override;
+  virtual int getViewIndexStamp(Vec2 pos) const override;
   virtual void refreshGameInfo(View::GameInfo&) const  override;
   virtual Vec2 getPosition() const  override;
   virtual bool canSee(const Creature*) const  override;
@@ -66,6 +67,8 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
   virtual void onTechBookEvent(Technology*) override;
   virtual void onEquipEvent(const Creature*, const Item*) override;
   virtual void onPickupEvent(const Creature* c, const vector<Item*>& items);
+  virtual void onDropEvent(const Creature* c, const vector<Item*>& items);
+  virtual void onItemsAppearedEvent(Vec2 position, const vector<Item*>& items);
   virtual void onSurrenderEvent(Creature* who, const Creature* to);
   virtual void onTortureEvent(Creature* who, const Creature* torturer);
 
@@ -166,6 +169,7 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
   static void registerTypes(Archive& ar);
 
   private:
+  friend class KeeperStress;
   Creature* addCreature(PCreature c, Vec2 v, MinionType);
   Creature* getCreature(UniqueId id);
   void handleCreatureButton(Creature* c, View* view);
@@ -280,6 +284,22 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
       int* index = nullptr, double* scrollPos = nullptr) const;
   bool usesEquipment(const Creature* c) const;
   void autoEquipment(Creature* creature, bool replace);
+  struct EquipmentEntry {
+    UniqueId id;
+    Vec2 position;
+    const Creature* carrier;
+    int value;
+  };
+  struct EquipmentIndex {
+    vector<EquipmentEntry> freeItems[MinionEquipment::numEquipmentTypes];
+    unordered_map<const Creature*, vector<EquipmentEntry>> ownedItems;
+    bool noWeapons = false;
+    bool dirty = true;
+    int numChanges = -1;
+    double lastUpdate = -1000;
+  };
+  void updateEquipmentIndex();
+  Item* getIndexedItem(const EquipmentEntry&);
   MinionType getMinionType(const Creature*) const;
   void setMinionType(Creature*, MinionType type);
 
@@ -302,6 +322,15 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
   bool underAttack() const;
   void addToMemory(Vec2 pos);
   void updateMemory();
+  struct MemoryInfo {
+    MemoryInfo(Rectangle bounds);
+    // Square::getVersion() of each tile at the time it was written to memory.
+    Table<int> version;
+    // Number of the last updateMemory() call in which the tile was visible to any minion.
+    Table<int> lastSeen;
+    int numUpdates = 0;
+  };
+  MemoryInfo& getMemoryInfo();
   bool isItemMarked(const Item*) const;
   void markItem(const Item*);
   void unmarkItem(UniqueId);
@@ -310,7 +339,16 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
 
   vector<pair<Item*, Vec2>> getTrapItems(TrapType, set<Vec2> = {}) const;
   ItemPredicate unMarkedItems(ItemType) const;
-  MarkovChain<MinionTask> getTasksForMinion(Creature* c);
+  enum class TaskChain { KEEPER, PRISONER, GOLEM, UNDEAD, VAMPIRE_LORD, GNOME, NORMAL };
+  TaskChain getTaskChain(Creature* c) const;
+  static const MarkovChain<MinionTask>& getTaskTransitions(TaskChain);
+  struct MinionTaskState {
+    TaskChain chain;
+    MinionTask task;
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int version);
+  };
+  MinionTaskState getInitialTasks(Creature* c) const;
   vector<Creature*> SERIAL(creatures);
   vector<Creature*> SERIAL(minions);
   unordered_map<MinionType, vector<Creature*>> SERIAL(minionByType);
@@ -364,13 +402,14 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
   void setMinionTask(Creature* c, MinionTask task);
   MinionTask getMinionTask(Creature* c) const;
   map<Vec2, ConstructionInfo> SERIAL(constructions);
-  map<UniqueId, MarkovChain<MinionTask>> SERIAL(minionTasks);
+  map<UniqueId, MinionTaskState> SERIAL(minionTasks);
   map<UniqueId, string> SERIAL(minionTaskStrings);
   map<SquareType, set<Vec2>> SERIAL(mySquares);
   set<Vec2> SERIAL(myTiles);
   Level* SERIAL(level);
   Creature* SERIAL2(keeper, nullptr);
   mutable unique_ptr<map<Level*, MapMemory>> SERIAL(memory);
+  unique_ptr<MemoryInfo> memoryInfo;
   Table<bool> SERIAL(knownTiles);
   set<Vec2> SERIAL(borderTiles);
   bool SERIAL2(gatheringTeam, false);
@@ -379,6 +418,7 @@ class Collective : public CreatureView, public EventListener, public Task::Callb
   map<const Level*, Vec2> SERIAL(levelChangeHistory);
   Creature* SERIAL2(possessed, nullptr);
   MinionEquipment SERIAL(minionEquipment);
+  EquipmentIndex equipmentIndex;
   struct GuardPostInfo {
     const Creature* attender;
     template <class Archive>
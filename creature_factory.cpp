@@ -899,8 +899,7 @@ CreatureFactory CreatureFactory::singleType(Tribe* tribe, CreatureId id) {
 }*/
 
 PCreature getSpecial(const string& name, Tribe* tribe, bool humanoid, ControllerFactory factory, bool keeper) {
-  RandomGen r;
-  r.init(hash<string>()(name));
+  RandomGen r = RandomGen().getStream(name);
   PCreature c = get(CATTR(
         c.viewId = humanoid ? ViewId::SPECIAL_HUMANOID : ViewId::SPECIAL_BEAST;
         c.speed = r.getRandom(70, 150);
@@ -25,6 +25,11 @@ class CreatureView {
   public:
   virtual const MapMemory& getMemory() const = 0;
   virtual ViewIndex getViewIndex(Vec2 pos) const = 0;
+
+  /** Returns a value that changes whenever the viewer's own additions to getViewIndex(pos) change,
+    * apart from those concerning a creature standing on the tile.*/
+  virtual int getViewIndexStamp(Vec2 pos) const { return 0; }
+
   virtual void refreshGameInfo(View::GameInfo&) const = 0;
   virtual Vec2 getPosition() const = 0;
   virtual bool staticPosition() const { return true; }
@@ -29,6 +29,8 @@ Debug::Debug(DebugType t, const string& msg, int line)
 }
 
 static ofstream output;
+// levels are generated on several threads, which all log here
+static std::mutex outputMutex;
 
 void Debug::init() {
   output.open("log.out");
@@ -39,11 +41,15 @@ void Debug::add(const string& a) {
 }
 Debug::~Debug() {
   if (type == FATAL) {
-    output << out << endl;
-    output.flush();
+    {
+      std::unique_lock<std::mutex> lock(outputMutex);
+      output << out << endl;
+      output.flush();
+    }
     throw out;
   } else {
 #ifndef RELEASE
+    std::unique_lock<std::mutex> lock(outputMutex);
     output << out << endl;
     output.flush();
 #endif
@@ -65,6 +71,53 @@ Debug& Debug::operator <<(const double msg) {
   add(convertToString(msg));
   return *this;
 }
+static bool profilerEnabled = false;
+static vector<Profiler::Entry> profilerEntries;
+
+static long long getMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Profiler::setEnabled(bool e) {
+  profilerEnabled = e;
+}
+
+void Profiler::clear() {
+  for (Entry& elem : profilerEntries) {
+    elem.totalMilli = 0;
+    elem.numCalls = 0;
+    elem.count = 0;
+  }
+}
+
+vector<Profiler::Entry> Profiler::getEntries() {
+  return profilerEntries;
+}
+
+int Profiler::getId(const char* name) {
+  for (int i : All(profilerEntries))
+    if (profilerEntries[i].name == name)
+      return i;
+  profilerEntries.push_back({name, 0, 0, 0});
+  return profilerEntries.size() - 1;
+}
+
+void Profiler::addCount(int id, long long num) {
+  if (profilerEnabled)
+    profilerEntries[id].count += num;
+}
+
+Profiler::Scope::Scope(int i) : id(i), start(profilerEnabled ? getMicros() : -1) {
+}
+
+Profiler::Scope::~Scope() {
+  if (start >= 0) {
+    profilerEntries[id].totalMilli += double(getMicros() - start) / 1000;
+    ++profilerEntries[id].numCalls;
+  }
+}
+
 template<class T>
 Debug& Debug::operator<<(const vector<T>& container){
   (*this) << "{";
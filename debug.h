@@ -50,6 +50,41 @@
 
 #endif
 
+/** Accumulates the time spent in named parts of the code. It's off by default, in which case
+    a profiled scope costs a single branch.*/
+class Profiler {
+  public:
+  static void setEnabled(bool);
+  static void clear();
+
+  struct Entry {
+    string name;
+    double totalMilli;
+    int numCalls;
+    long long count;
+  };
+  static vector<Entry> getEntries();
+
+  static int getId(const char* name);
+
+  /** Adds to the entry's count, e.g. the number of objects handled in a profiled scope.*/
+  static void addCount(int id, long long num);
+
+  class Scope {
+    public:
+    Scope(int id);
+    ~Scope();
+
+    private:
+    int id;
+    long long start;
+  };
+};
+
+#define PROFILE(name) static int profilerId = Profiler::getId(name); Profiler::Scope profilerScope(profilerId)
+#define PROFILE_COUNT(name, num) \
+  do { static int profilerCountId = Profiler::getId(name); Profiler::addCount(profilerCountId, num); } while (0)
+
 enum DebugType { INFO, FATAL };
 
 class NoDebug {
@@ -111,6 +111,7 @@ enum class SquareAttrib {
   EMPTY_ROOM,
   FOG,
   FORREST,
+  ENUM_END
 };
 
 ENUM_HASH(SquareAttrib);
@@ -294,6 +295,7 @@ enum class ViewLayer {
   ITEM,
   FLOOR,
   FLOOR_BACKGROUND,
+  ENUM_END
 };
 
 enum class HighlightType {
@@ -303,6 +305,7 @@ enum class HighlightType {
   FOG,
   MEMORY,
   NIGHT,
+  ENUM_END
 };
 
 enum class StairLook {
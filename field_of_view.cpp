@@ -71,40 +71,7 @@ void FieldOfView::Visibility::setVisible(int x, int y) {
 static int totalIter = 0;
 static int numSamples = 0;
 
-FieldOfView::Visibility::Visibility(const Table<PSquare>& squares, Vision* vision, int x, int y) : px(x), py(y) {
-  memset(visible, 0, (2 * sightRange + 1) * (2 * sightRange + 1));
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x + px][y + py]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(px ,py); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange, 2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x + py][y - px]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(py, -px); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x - px][y - py]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(-px, -py); });
-  calculate(2 * sightRange, 2 * sightRange,2 * sightRange,2,-1,1,1,1,
-      [&](int px, int py) { return !squares[x - py][y + px]->canSeeThru(vision); },
-      [&](int px, int py) { setVisible(-py, px); });
-  setVisible(0, 0);
-/*  ++numSamples;
-  totalIter += visibleTiles.size();
-  if (numSamples%100 == 0)
-    Debug() << numSamples << " iterations " << totalIter / numSamples << " avg";*/
-}
-
-const vector<Vec2>& FieldOfView::Visibility::getVisibleTiles() const {
-  return visibleTiles;
-}
-
-const vector<Vec2>& FieldOfView::getVisibleTiles(Vec2 from) {
-  if (!visibility[from]) {
-    visibility[from] = Visibility(*squares, vision, from.x, from.y);
-  }
-  return visibility[from]->getVisibleTiles();
-}
-
-
-void FieldOfView::Visibility::calculate(int left, int right, int up, int h, int x1, int y1, int x2, int y2,
+static void calculate(int left, int right, int up, int h, int x1, int y1, int x2, int y2,
     function<bool (int, int)> isBlocking, function<void (int, int)> setVisible){
   if (y2*x1>=y1*x2) return;
   if (h>up) return;
@@ -143,6 +110,58 @@ void FieldOfView::Visibility::calculate(int left, int right, int up, int h, int
   calculate(left, right, up, h + 2, leftx, lefty, rightx, righty, isBlocking, setVisible);
 }
 
+static void computeVisible(const Table<PSquare>& squares, Vision* vision, int x, int y, int range,
+    function<void (int, int)> setVisible) {
+  calculate(2 * range, 2 * range, 2 * range, 2, -1, 1, 1, 1,
+      [&](int px, int py) { return !squares[x + px][y + py]->canSeeThru(vision); },
+      [&](int px, int py) { setVisible(px, py); });
+  calculate(2 * range, 2 * range, 2 * range, 2, -1, 1, 1, 1,
+      [&](int px, int py) { return !squares[x + py][y - px]->canSeeThru(vision); },
+      [&](int px, int py) { setVisible(py, -px); });
+  calculate(2 * range, 2 * range, 2 * range, 2, -1, 1, 1, 1,
+      [&](int px, int py) { return !squares[x - px][y - py]->canSeeThru(vision); },
+      [&](int px, int py) { setVisible(-px, -py); });
+  calculate(2 * range, 2 * range, 2 * range, 2, -1, 1, 1, 1,
+      [&](int px, int py) { return !squares[x - py][y + px]->canSeeThru(vision); },
+      [&](int px, int py) { setVisible(-py, px); });
+  setVisible(0, 0);
+}
+
+FieldOfView::Visibility::Visibility(const Table<PSquare>& squares, Vision* vision, int x, int y) : px(x), py(y) {
+  PROFILE("FieldOfView");
+  memset(visible, 0, (2 * sightRange + 1) * (2 * sightRange + 1));
+  computeVisible(squares, vision, x, y, sightRange, [&](int px, int py) { setVisible(px, py); });
+/*  ++numSamples;
+  totalIter += visibleTiles.size();
+  if (numSamples%100 == 0)
+    Debug() << numSamples << " iterations " << totalIter / numSamples << " avg";*/
+}
+
+const vector<Vec2>& FieldOfView::Visibility::getVisibleTiles() const {
+  return visibleTiles;
+}
+
+const vector<Vec2>& FieldOfView::getVisibleTiles(Vec2 from) {
+  if (!visibility[from]) {
+    visibility[from] = Visibility(*squares, vision, from.x, from.y);
+  }
+  return visibility[from]->getVisibleTiles();
+}
+
+vector<Vec2> FieldOfView::getVisibleTiles(const Table<PSquare>& squares, Vision* vision, Vec2 from, int range) {
+  int size = 2 * range + 1;
+  vector<char> visible(size * size, 0);
+  vector<Vec2> ret;
+  computeVisible(squares, vision, from.x, from.y, range, [&](int x, int y) {
+      char& v = visible[(x + range) * size + y + range];
+      if (!v && x * x + y * y <= range * range) {
+        v = 1;
+        ret.push_back(from + Vec2(x, y));
+      }});
+  return ret;
+}
+
+
 bool FieldOfView::Visibility::checkVisible(int x, int y) const {
   return x >= -sightRange && y >= -sightRange && x <= sightRange && y <= sightRange && 
     visible[sightRange + x][sightRange + y] == 1;
@@ -26,6 +26,10 @@ class FieldOfView {
   const vector<Vec2>& getVisibleTiles(Vec2 from);
   void squareChanged(Vec2 pos);
 
+  /** Returns the tiles visible from the given square within given distance. The result isn't cached,
+      but only the squares within the distance are examined.*/
+  static vector<Vec2> getVisibleTiles(const Table<PSquare>& squares, Vision*, Vec2 from, int range);
+
   SERIALIZATION_DECL(FieldOfView);
 
   private:
@@ -48,9 +52,6 @@ class FieldOfView {
     char visible[sightRange * 2 + 1][sightRange * 2 + 1];
     SERIAL3(visible);
     vector<Vec2> SERIAL(visibleTiles);
-    void calculate(int,int,int,int, int, int, int, int,
-        function<bool (int, int)> isBlocking,
-        function<void (int, int)> setVisible);
     void setVisible(int, int);
 
     int SERIAL(px);
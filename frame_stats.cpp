@@ -0,0 +1,118 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "frame_stats.h"
+#include "enums.h"
+
+FrameStats::FrameStats(int c) : capacity(c) {
+  CHECK(capacity > 0);
+}
+
+void FrameStats::startFrame() {
+  if (frames.size() < capacity)
+    frames.emplace_back();
+  else
+    frames[next].clear();
+  next = (next + 1) % capacity;
+}
+
+void FrameStats::add(FramePhase phase, double milli) {
+  CHECK(!frames.empty()) << "No frame started";
+  frames[(next + capacity - 1) % capacity][phase] += milli;
+}
+
+void FrameStats::clear() {
+  frames.clear();
+  next = 0;
+}
+
+int FrameStats::getNumFrames() const {
+  return frames.size();
+}
+
+const EnumMap<FramePhase, double>& FrameStats::getFrame(int frame) const {
+  CHECK(frame >= 0 && frame < frames.size());
+  if (frames.size() < capacity)
+    return frames[frame];
+  else
+    return frames[(next + frame) % capacity];
+}
+
+double FrameStats::getTime(int frame, FramePhase phase) const {
+  return getFrame(frame)[phase];
+}
+
+double FrameStats::getTotalTime(int frame) const {
+  double ret = 0;
+  for (FramePhase phase : ENUM_ALL(FramePhase))
+    ret += getFrame(frame)[phase];
+  return ret;
+}
+
+static double getPercentile(vector<double> times, double fraction) {
+  if (times.empty())
+    return 0;
+  int index = min<int>(times.size() - 1, fraction * times.size());
+  std::nth_element(times.begin(), times.begin() + index, times.end());
+  return times[index];
+}
+
+double FrameStats::getPercentile(FramePhase phase, double fraction) const {
+  vector<double> times;
+  for (auto& frame : frames)
+    times.push_back(frame[phase]);
+  return ::getPercentile(times, fraction);
+}
+
+double FrameStats::getTotalPercentile(double fraction) const {
+  vector<double> times;
+  for (int i : All(frames))
+    times.push_back(getTotalTime(i));
+  return ::getPercentile(times, fraction);
+}
+
+const char* FrameStats::getName(FramePhase phase) {
+  switch (phase) {
+    case FramePhase::VIEW_INDEX: return "view_index";
+    case FramePhase::MINIMAP: return "minimap";
+    case FramePhase::GUI: return "gui";
+    case FramePhase::MAP: return "map";
+    case FramePhase::FLIP: return "flip";
+    END_CASE(FramePhase);
+  }
+  return "";
+}
+
+void FrameStats::printCsv(std::ostream& out) const {
+  out << "frame";
+  for (FramePhase phase : ENUM_ALL(FramePhase))
+    out << "," << getName(phase);
+  out << ",total" << std::endl;
+  for (int i : All(frames)) {
+    out << i;
+    for (FramePhase phase : ENUM_ALL(FramePhase))
+      out << "," << getTime(i, phase);
+    out << "," << getTotalTime(i) << std::endl;
+  }
+}
+
+FrameStats::Timer::Timer(FrameStats& s, FramePhase p) : stats(s), phase(p), start(std::chrono::steady_clock::now()) {
+}
+
+FrameStats::Timer::~Timer() {
+  stats.add(phase, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
@@ -0,0 +1,81 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _FRAME_STATS_H
+#define _FRAME_STATS_H
+
+#include "util.h"
+
+enum class FramePhase {
+  VIEW_INDEX,
+  MINIMAP,
+  GUI,
+  MAP,
+  FLIP,
+
+  ENUM_END
+};
+
+/**
+  * Keeps the time spent in each phase of the last frames in a ring buffer of a fixed size.
+  */
+class FrameStats {
+  public:
+  FrameStats(int capacity);
+
+  /** Starts recording a new frame, replacing the oldest one if the buffer is full.*/
+  void startFrame();
+
+  /** Adds time spent in a phase of the current frame.*/
+  void add(FramePhase, double milli);
+
+  void clear();
+
+  int getNumFrames() const;
+
+  /** Returns the time spent in a phase of a frame, where frame 0 is the oldest one kept.*/
+  double getTime(int frame, FramePhase) const;
+  double getTotalTime(int frame) const;
+
+  /** Returns the time below which the given fraction of the frames spent in the phase.*/
+  double getPercentile(FramePhase, double fraction) const;
+  double getTotalPercentile(double fraction) const;
+
+  /** Prints one line per frame, oldest first, with the time of each phase and the total.*/
+  void printCsv(std::ostream&) const;
+
+  static const char* getName(FramePhase);
+
+  /** Adds the time spent in its scope to a phase of the current frame.*/
+  class Timer {
+    public:
+    Timer(FrameStats&, FramePhase);
+    ~Timer();
+
+    private:
+    FrameStats& stats;
+    FramePhase phase;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  private:
+  const EnumMap<FramePhase, double>& getFrame(int frame) const;
+
+  vector<EnumMap<FramePhase, double>> frames;
+  int capacity;
+  int next = 0;
+};
+
+#endif
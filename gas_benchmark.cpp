@@ -0,0 +1,55 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "gas_benchmark.h"
+#include "poison_gas.h"
+
+GasBenchmark::GasBenchmark(int s, int n) : size(s), numTurns(n) {
+  CHECK(size > 10 && numTurns > 0);
+}
+
+void GasBenchmark::run() {
+  times.clear();
+  numActive.clear();
+  Rectangle bounds(size, size);
+  Table<bool> blocked(bounds, false);
+  for (Vec2 v : bounds)
+    blocked[v] = !v.inRectangle(bounds.minusMargin(1)) || (v.x % 6 == 0 && v.y % 6 == 0);
+  PoisonGas gas(bounds);
+  Rectangle source(Vec2(size * 2 / 5, size * 2 / 5), Vec2(size * 3 / 5, size * 3 / 5));
+  double total = 0;
+  for (int turn : Range(numTurns)) {
+    auto start = std::chrono::steady_clock::now();
+    if (turn < numTurns / 4)
+      for (Vec2 v : source)
+        if (!blocked[v])
+          gas.addAmount(v, 3);
+    gas.tick([&](Vec2 v) { return !blocked[v]; });
+    total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if ((turn + 1) % 100 == 0) {
+      times.push_back(total / 100);
+      numActive.push_back(gas.getNumActive());
+      total = 0;
+    }
+  }
+}
+
+void GasBenchmark::printResults(std::ostream& out) const {
+  out << "turn,ms,cells" << endl;
+  for (int i : All(times))
+    out << (i + 1) * 100 << "," << times[i] << "," << numActive[i] << endl;
+}
@@ -0,0 +1,42 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _GAS_BENCHMARK_H
+#define _GAS_BENCHMARK_H
+
+#include "util.h"
+
+/**
+  * Measures how long it takes to simulate a large cloud of poison gas spreading over an open map with
+  * scattered pillars. Gas is released over the middle fifth of the map for the first quarter of the turns
+  * and then left to dissipate.
+  */
+class GasBenchmark {
+  public:
+  GasBenchmark(int size, int numTurns);
+
+  void run();
+
+  /** Prints the time per turn and the number of cells with gas every 100 turns as CSV.*/
+  void printResults(std::ostream&) const;
+
+  private:
+  int size;
+  int numTurns;
+  vector<double> times;
+  vector<int> numActive;
+};
+
+#endif
@@ -33,9 +33,19 @@ void GuiElem::setBounds(Rectangle b) {
   onRefreshBounds();
 }
 
+static int numCreated = 0;
+
+GuiElem::GuiElem() {
+  ++numCreated;
+}
+
 GuiElem::~GuiElem() {
 }
 
+int GuiElem::getNumCreated() {
+  return numCreated;
+}
+
 class Button : public GuiElem {
   public:
   Button(function<void()> f, char key) : fun(f), hotkey(key) {}
@@ -156,6 +166,16 @@ PGuiElem GuiElem::label(const string& s, Color c, char hotkey) {
         }));
 }
 
+PGuiElem GuiElem::variableLabel(function<string()> text, Color c) {
+  return PGuiElem(new DrawCustom(
+        [=] (Renderer& r, Rectangle bounds) {
+          string s = text();
+          r.drawTextWithHotkey(transparency(black, 100),
+            bounds.getTopLeft().x + 1, bounds.getTopLeft().y + 2, s, 0);
+          r.drawTextWithHotkey(c, bounds.getTopLeft().x, bounds.getTopLeft().y, s, 0);
+        }));
+}
+
 PGuiElem GuiElem::label(sf::Uint32 s, Color color, int size, Renderer::FontId fontId) {
   return PGuiElem(new DrawCustom(
         [=] (Renderer& r, Rectangle bounds) {
@@ -33,10 +33,14 @@ class GuiElem {
   void setBounds(Rectangle);
   Rectangle getBounds();
 
+  GuiElem();
   virtual ~GuiElem();
 
   Rectangle bounds;
 
+  /** Returns how many GuiElems have been created since the program started.*/
+  static int getNumCreated();
+
   static void initialize(const string& texturePath);
 
   static PGuiElem button(function<void()> fun, char hotkey = 0);
@@ -57,6 +61,8 @@ class GuiElem {
   static PGuiElem margins(PGuiElem content, int left, int top, int right, int bottom);
   static PGuiElem label(const string&, Color, char hotkey = 0);
   static PGuiElem label(sf::Uint32, Color, int size, Renderer::FontId);
+  /** A label that asks for its text every time it's drawn, so it doesn't have to be rebuilt when the text changes.*/
+  static PGuiElem variableLabel(function<string()> text, Color);
   static PGuiElem viewObject(const ViewObject& object, bool useSprites);
   static PGuiElem drawCustom(function<void(Renderer&, Rectangle)>);
   static PGuiElem translate(PGuiElem, Vec2, Rectangle newSize);
@@ -0,0 +1,239 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+#include "keeper_stress.h"
+#include "model.h"
+#include "collective.h"
+#include "creature.h"
+#include "creature_factory.h"
+#include "item_factory.h"
+#include "technology.h"
+#include "message_buffer.h"
+
+/** A view that displays nothing and never asks the player for anything.*/
+class HeadlessView : public View {
+  public:
+  virtual void initialize() override {}
+  virtual void reset() override {}
+  virtual void displaySplash(SplashType, bool& ready) override {}
+  virtual void close() override {}
+  virtual void refreshView(const CreatureView*) override {}
+  virtual void updateView(const CreatureView*) override {}
+  virtual void drawLevelMap(const CreatureView*) override {}
+  virtual void resetCenter() override {}
+  virtual void addMessage(const string& message) override {}
+  virtual void addImportantMessage(const string& message) override {}
+  virtual void clearMessages() override {}
+  virtual void retireMessages() override {}
+  virtual UserInput getAction() override { return UserInput(UserInput::IDLE); }
+  virtual bool travelInterrupt() override { return false; }
+  virtual Optional<int> chooseFromList(const string& title, const vector<ListElem>& options, int index,
+      MenuType, double* scrollPos, Optional<UserInput::Type> exitAction) override { return Nothing(); }
+  virtual Optional<Vec2> chooseDirection(const string& message) override { return Nothing(); }
+  virtual bool yesOrNoPrompt(const string& message) override { return false; }
+  virtual void presentText(const string& title, const string& text) override {}
+  virtual void presentList(const string& title, const vector<ListElem>& options, bool scrollDown,
+      Optional<UserInput::Type> exitAction) override {}
+  virtual Optional<int> getNumber(const string& title, int min, int max, int increments) override {
+    return Nothing();
+  }
+  virtual void animateObject(vector<Vec2> trajectory, ViewObject object) override {}
+  virtual void animation(Vec2 pos, AnimationId) override {}
+  virtual int getTimeMilli() override { return time; }
+  virtual void stopClock() override {}
+  virtual void setTimeMilli(int t) override { time = t; }
+  virtual void continueClock() override {}
+  virtual bool isClockStopped() override { return false; }
+
+  private:
+  int time = 0;
+};
+
+KeeperStress::KeeperStress(const Scenario& s) : scenario(s) {
+  CHECK(scenario.numDug > 0) << "The scenario needs some dug squares to put the minions on.";
+}
+
+void KeeperStress::construct(Collective* col, Vec2 pos, SquareType type) {
+  while (!col->level->getSquare(pos)->construct(type)) {}
+  col->onConstructed(pos, type);
+  col->addKnownTile(pos);
+}
+
+void KeeperStress::dig(Collective* col) {
+  Level* level = col->level;
+  const Collective::BuildInfo* digInfo = nullptr;
+  for (const Collective::BuildInfo& info : Collective::buildInfo)
+    if (info.buildType == Collective::BuildInfo::DIG)
+      digInfo = &info;
+  // Besides the dug squares, leave some more marked for the imps to dig.
+  int numMarked = scenario.numDug / 10;
+  Table<bool> visited(level->getBounds(), false);
+  queue<Vec2> q;
+  Vec2 start = col->getKeeper()->getPosition();
+  visited[start] = true;
+  q.push(start);
+  while (!q.empty() && (dug.size() < scenario.numDug || numMarked > 0)) {
+    Vec2 pos = q.front();
+    q.pop();
+    for (Vec2 v : pos.neighbors4())
+      if (level->inBounds(v) && !visited[v]) {
+        visited[v] = true;
+        Square* square = level->getSquare(v);
+        if (square->canEnterEmpty(Creature::getDefaultMinion()))
+          q.push(v);
+        else if (square->canConstruct(SquareType::FLOOR)) {
+          if (dug.size() < scenario.numDug) {
+            construct(col, v, SquareType::FLOOR);
+            dug.push_back(v);
+            q.push(v);
+          } else if (numMarked > 0) {
+            col->handleSelection(v, *NOTNULL(digInfo), true);
+            --numMarked;
+          }
+        }
+      }
+  }
+  if (dug.size() < scenario.numDug)
+    Debug() << "Stress test: only " << int(dug.size()) << " squares could be dug";
+}
+
+void KeeperStress::buildRooms(Collective* col) {
+  vector<pair<const Collective::BuildInfo*, int>> rooms;
+  for (const Collective::BuildInfo& info : Collective::buildInfo)
+    if (info.buildType == Collective::BuildInfo::SQUARE)
+      for (int i : All(info.squareInfo))
+        rooms.push_back({&info, i});
+  // Rooms take up the deeper half of the dungeon. Every fourth square is left for the imps to build.
+  int roomSize = dug.size() / 2 / rooms.size();
+  for (int i : All(rooms)) {
+    const Collective::BuildInfo& info = *rooms[i].first;
+    SquareType type = info.squareInfo[rooms[i].second].type;
+    for (int j : Range(roomSize)) {
+      Vec2 pos = dug[dug.size() / 2 + i * roomSize + j];
+      if (!col->level->getSquare(pos)->canConstruct(type))
+        continue;
+      if (j % 4 == 3)
+        col->handleSelection(pos, info, true, rooms[i].second);
+      else
+        construct(col, pos, type);
+    }
+  }
+}
+
+Vec2 KeeperStress::getFreeTile(Collective* col, const Creature* c) const {
+  for (int i : Range(1000)) {
+    Vec2 pos = dug[Random.getRandom(dug.size())];
+    if (col->level->getSquare(pos)->canEnter(c))
+      return pos;
+  }
+  FAIL << "Stress test: no free square for " << c->getName();
+  return Vec2(0, 0);
+}
+
+static vector<pair<CreatureId, MinionType>> stressMinions {
+  {CreatureId::GNOME, MinionType::NORMAL},
+  {CreatureId::GOBLIN, MinionType::NORMAL},
+  {CreatureId::BILE_DEMON, MinionType::NORMAL},
+  {CreatureId::ZOMBIE, MinionType::UNDEAD},
+  {CreatureId::STONE_GOLEM, MinionType::GOLEM},
+  {CreatureId::WOLF, MinionType::BEAST},
+};
+
+void KeeperStress::addMinions(Collective* col) {
+  for (int i : Range(scenario.numImps)) {
+    PCreature c = CreatureFactory::fromId(CreatureId::IMP, col->tribe, MonsterAIFactory::collective(col));
+    Vec2 pos = getFreeTile(col, c.get());
+    col->addCreature(std::move(c), pos, MinionType::IMP);
+  }
+  for (int i : Range(scenario.numMinions)) {
+    pair<CreatureId, MinionType> elem = stressMinions[i % stressMinions.size()];
+    PCreature c = CreatureFactory::fromId(elem.first, col->tribe, MonsterAIFactory::collective(col));
+    Vec2 pos = getFreeTile(col, c.get());
+    col->addCreature(std::move(c), pos, elem.second);
+  }
+}
+
+void KeeperStress::dropItems(Collective* col) {
+  vector<ItemFactory> factories { ItemFactory::armory(), ItemFactory::dungeon() };
+  int numDropped = 0;
+  while (numDropped < scenario.numItems) {
+    Vec2 pos = dug[Random.getRandom(dug.size())];
+    for (PItem& item : factories[numDropped % factories.size()].random()) {
+      col->level->getSquare(pos)->dropItem(std::move(item));
+      ++numDropped;
+    }
+  }
+}
+
+void KeeperStress::run() {
+  HeadlessView view;
+  messageBuffer.initialize(&view);
+  unique_ptr<Model> model;
+  MEASURE({
+    for (int i : Range(5)) {
+      try {
+        model.reset(Model::collectiveModel(&view));
+        break;
+      } catch (string s) {
+        Debug() << "Stress test: world generation failed: " << s;
+      }
+    }
+    CHECK(model) << "World generation permanently failed";
+    Collective* col = model->collective.get();
+    for (Technology* tech : Technology::getSorted())
+      if (!contains(col->technologies, tech))
+        col->acquireTech(tech, true);
+    for (auto& elem : Collective::resourceInfo)
+      col->credit[elem.first] = 1000000;
+    dig(col);
+    buildRooms(col);
+    addMinions(col);
+    dropItems(col);
+  }, "Stress test setup");
+  double startTime = model->collective->getKeeper()->getTime();
+  Profiler::clear();
+  Profiler::setEnabled(true);
+  try {
+    PROFILE("Model::update");
+    model->update(startTime + scenario.numTurns);
+  } catch (GameOverException) {
+    Debug() << "Stress test: the keeper died";
+  }
+  Profiler::setEnabled(false);
+  turnsRun = model->currentTime - startTime;
+  results = Profiler::getEntries();
+  for (Profiler::Entry& elem : results)
+    Debug() << "Stress test: " << elem.name << " " << elem.totalMilli << " ms in "
+        << elem.numCalls << " calls, count " << int(elem.count);
+}
+
+void KeeperStress::printResults(std::ostream& out) const {
+  out << "dug,minions,imps,items,turns";
+  for (const Profiler::Entry& elem : results) {
+    out << "," << elem.name << " ms," << elem.name << " calls";
+    if (elem.count > 0)
+      out << "," << elem.name << " count";
+  }
+  out << endl;
+  out << dug.size() << "," << scenario.numMinions << "," << scenario.numImps << "," << scenario.numItems
+      << "," << turnsRun;
+  for (const Profiler::Entry& elem : results) {
+    out << "," << elem.totalMilli << "," << elem.numCalls;
+    if (elem.count > 0)
+      out << "," << elem.count;
+  }
+  out << endl;
+}
@@ -0,0 +1,64 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _KEEPER_STRESS_H
+#define _KEEPER_STRESS_H
+
+#include "util.h"
+#include "debug.h"
+
+class Collective;
+class Creature;
+
+/**
+  * Builds a keeper game with a dungeon of a given size and runs it without a display,
+  * measuring how much time the collective's subsystems take.
+  */
+class KeeperStress {
+  public:
+  struct Scenario {
+    int numDug;
+    int numMinions;
+    int numImps;
+    int numItems;
+    int numTurns;
+  };
+
+  KeeperStress(const Scenario&);
+
+  /** Generates the world, builds the dungeon and runs the turns. The global game state
+      has to be initialized beforehand.*/
+  void run();
+
+  /** Prints the scenario and the time spent in each profiled subsystem as CSV.*/
+  void printResults(std::ostream&) const;
+
+  private:
+  void dig(Collective*);
+  void buildRooms(Collective*);
+  void addMinions(Collective*);
+  void dropItems(Collective*);
+  void construct(Collective*, Vec2 pos, SquareType);
+  Vec2 getFreeTile(Collective*, const Creature*) const;
+
+  Scenario scenario;
+  vector<Vec2> dug;
+  double setupMilli = 0;
+  double runMilli = 0;
+  double turnsRun = 0;
+  vector<Profiler::Entry> results;
+};
+
+#endif
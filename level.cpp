@@ -34,7 +34,13 @@ void Level::serialize(Archive& ar, const unsigned int version) {
     & SVAR(backgroundLevel)
     & SVAR(backgroundOffset)
     & SVAR(coverInfo)
-    & SVAR(lightAmount);
+    & SVAR(lightMap)
+    & SVAR(poisonGas);
+  if (Archive::is_loading::value) {
+    tickingIndex = Table<int>(squares.getBounds(), -1);
+    for (int i : All(tickingSquares))
+      tickingIndex[tickingSquares[i]] = i;
+  }
   CHECK_SERIAL;
 }  
 
@@ -50,8 +56,8 @@ SERIALIZABLE(Level::CoverInfo);
 
 Level::Level(Table<PSquare> s, Model* m, vector<Location*> l, const string& message, const string& n,
     Table<CoverInfo> covers) 
-    : squares(std::move(s)), locations(l), model(m), entryMessage(message), name(n), coverInfo(std::move(covers)),
-      lightAmount(squares.getBounds(), 0) {
+    : squares(std::move(s)), locations(l), tickingIndex(squares.getBounds(), -1), model(m), entryMessage(message), name(n), coverInfo(std::move(covers)),
+      lightMap(squares), poisonGas(squares.getBounds()) {
   for (Vec2 pos : squares.getBounds()) {
     squares[pos]->setLevel(this);
     Optional<pair<StairDirection, StairKey>> link = squares[pos]->getLandingLink();
@@ -63,7 +69,7 @@ Level::Level(Table<PSquare> s, Model* m, vector<Location*> l, const string& mess
   for (Vision* vision : Vision::getAll())
     fieldOfView.emplace(vision, FieldOfView(squares, vision));
   for (Vec2 pos : squares.getBounds())
-    addLightSource(pos, squares[pos]->getLightEmission(), 1);
+    lightMap.setSource(pos, squares[pos]->getLightEmission());
 }
 
 Rectangle Level::getMaxBounds() {
@@ -92,24 +98,12 @@ void Level::notifyLocations(Creature* c) {
       l->onCreature(c);
 }
 
-void Level::addLightSource(Vec2 pos, double radius, int numLight) {
-  if (radius > 0) {
-    for (Vec2 v : getVisibleTilesNoDarkness(pos, Vision::get(VisionId::NORMAL))) {
-      double dist = (v - pos).lengthD();
-      if (dist <= radius)
-        addLight(v, min(1.0, 1 - (dist) / radius) * numLight);
-    }
-  }
-}
-
 void Level::replaceSquare(Vec2 pos, PSquare square) {
-  if (contains(tickingSquares, getSquare(pos)))
-    removeElement(tickingSquares, getSquare(pos));
+  removeTickingSquare(pos);
   Creature* c = squares[pos]->getCreature();
   for (Item* it : squares[pos]->getItems())
     square->dropItem(squares[pos]->removeItem(it));
   squares[pos]->onConstructNewSquare(square.get());
-  addLightSource(pos, squares[pos]->getLightEmission(), -1);
   square->setBackground(squares[pos].get());
   squares[pos] = std::move(square);
   squares[pos]->setPosition(pos);
@@ -117,17 +111,14 @@ void Level::replaceSquare(Vec2 pos, PSquare square) {
   if (c) {
     squares[pos]->putCreatureSilently(c);
   }
-  addLightSource(pos, squares[pos]->getLightEmission(), 1);
+  lightMap.setSource(pos, squares[pos]->getLightEmission());
   updateVisibility(pos);
 }
 
 void Level::updateVisibility(Vec2 changedSquare) {
-  for (Vec2 pos : getVisibleTilesNoDarkness(changedSquare, Vision::get(VisionId::NORMAL)))
-    addLightSource(pos, squares[pos]->getLightEmission(), -1);
   for (auto& elem : fieldOfView)
     elem.second.squareChanged(changedSquare);
-  for (Vec2 pos : getVisibleTilesNoDarkness(changedSquare, Vision::get(VisionId::NORMAL)))
-    addLightSource(pos, squares[pos]->getLightEmission(), 1);
+  lightMap.squareChanged(changedSquare);
 }
 
 const Creature* Level::getPlayer() const {
@@ -157,8 +148,13 @@ double Level::getSunlight(Vec2 pos) const {
   return coverInfo[pos].sunlight * model->getSunlightInfo().lightAmount;
 }
 
+void Level::updateLight() const {
+  lightMap.update();
+}
+
 double Level::getTotalLight(Vec2 pos) const {
-  return lightAmount[pos] + getSunlight(pos);
+  updateLight();
+  return lightMap.getLight(pos) + getSunlight(pos);
 }
 
 double Level::getLight(Vec2 pos) const {
@@ -166,7 +162,7 @@ double Level::getLight(Vec2 pos) const {
 }
 
 void Level::addLight(Vec2 pos, double num) {
-  lightAmount[pos] += num;
+  lightMap.addLight(pos, num);
 }
 
 vector<Vec2> Level::getLandingSquares(StairDirection dir, StairKey key) const {
@@ -399,49 +395,125 @@ Square* Level::getSquare(Vec2 pos) {
 }
 
 void Level::addTickingSquare(Vec2 pos) {
-  Square* s = squares[pos].get();
-  if (!contains(tickingSquares, s))
-    tickingSquares.push_back(s);
+  if (tickingIndex[pos] == -1) {
+    tickingIndex[pos] = tickingSquares.size();
+    tickingSquares.push_back(pos);
+  }
+}
+
+void Level::removeTickingSquare(Vec2 pos) {
+  int index = tickingIndex[pos];
+  if (index > -1) {
+    Vec2 last = tickingSquares.back();
+    tickingSquares[index] = last;
+    tickingIndex[last] = index;
+    tickingSquares.pop_back();
+    tickingIndex[pos] = -1;
+  }
 }
   
-vector<Square*> Level::getTickingSquares() const {
-  return tickingSquares;
+int Level::getNumTickingSquares() const {
+  return tickingSquares.size();
+}
+
+void Level::tick(double time) {
+  PROFILE("Level::tick");
+  PROFILE_COUNT("Level::tick", tickingSquares.size());
+  // squares added during this turn are ticked from the next one
+  for (Vec2 pos : vector<Vec2>(tickingSquares))
+    if (tickingIndex[pos] > -1) {
+      squares[pos]->tick(time);
+      if (tickingIndex[pos] > -1 && !squares[pos]->needsTicking())
+        removeTickingSquare(pos);
+    }
+  for (Vec2 pos : poisonGas.tick([this](Vec2 v) { return squares[v]->canSeeThru(); }))
+    squares[pos]->tickPoisonGas();
+}
+
+void Level::addPoisonGas(Vec2 pos, double amount) {
+  poisonGas.addAmount(pos, amount);
+}
+
+double Level::getPoisonGasAmount(Vec2 pos) const {
+  return poisonGas.getAmount(pos);
+}
+
+static_assert(int(SquareAttrib::ENUM_END) <= 32, "SquareAttrib doesn't fit in the builder's attribute mask");
+
+static unsigned attribBit(SquareAttrib attr) {
+  return 1u << int(attr);
 }
 
 Level::Builder::Builder(int width, int height, const string& n, bool covered)
-  : squares(width, height), heightMap(width, height, 0),
-    coverInfo(width, height, {covered, covered ? 0.0 : 1.0}), attrib(width, height),
-    type(width, height, SquareType(0)), name(n) {
+  : squares(width, height), type(width, height, SquareType(0)), attrib(width, height, 0),
+    floorView(width, height, -1), heightMap(width, height, 0),
+    coverInfo(width, height, {covered, covered ? 0.0 : 1.0}), name(n) {
 }
 
-bool Level::Builder::hasAttrib(Vec2 posT, SquareAttrib attr) {
-  Vec2 pos = transform(posT);
-  CHECK(squares[pos] != nullptr);
-  return attrib[pos].count(attr);
+bool Level::Builder::hasAttrib(Vec2 pos, SquareAttrib attr) {
+  return attrib[transform(pos)] & attribBit(attr);
 }
 
 void Level::Builder::addAttrib(Vec2 pos, SquareAttrib attr) {
-  attrib[transform(pos)].insert(attr);
+  attrib[transform(pos)] |= attribBit(attr);
 }
 
 void Level::Builder::removeAttrib(Vec2 pos, SquareAttrib attr) {
-  attrib[transform(pos)].erase(attr);
+  attrib[transform(pos)] &= ~attribBit(attr);
+}
+
+const Level::Builder::Prototype& Level::Builder::getPrototype(SquareType t) {
+  Prototype& ret = prototypes[t];
+  if (!ret.square) {
+    ret.square = SquareFactory::get(t);
+    ret.floorView = -1;
+    if (ret.square->getViewObject().layer() == ViewLayer::FLOOR_BACKGROUND) {
+      ret.floorView = floorViews.size();
+      floorViews.push_back(ret.square->getViewObject());
+    }
+  }
+  return ret;
+}
+
+const Square* Level::Builder::peekSquare(Vec2 pos) {
+  if (squares[pos])
+    return squares[pos].get();
+  else
+    return getPrototype(type[pos]).square.get();
 }
 
-Square* Level::Builder::getSquare(Vec2 pos) {
-  return squares[transform(pos)].get();
+Square* Level::Builder::getSquare(Vec2 posT) {
+  Vec2 pos = transform(posT);
+  if (!squares[pos]) {
+    squares[pos] = SquareFactory::get(type[pos]);
+    squares[pos]->setPosition(pos);
+  }
+  return squares[pos].get();
+}
+
+bool Level::Builder::canEnter(Vec2 pos, const Creature* c) {
+  return peekSquare(transform(pos))->canEnter(c);
+}
+
+bool Level::Builder::canEnterEmpty(Vec2 pos, const Creature* c) {
+  return peekSquare(transform(pos))->canEnterEmpty(c);
 }
     
 SquareType Level::Builder::getType(Vec2 pos) {
   return type[transform(pos)];
 }
 
-void Level::Builder::putSquare(Vec2 pos, SquareType t, Optional<SquareAttrib> at) {
-  putSquare(pos, SquareFactory::get(t), t, at);
+void Level::Builder::putSquare(Vec2 pos, SquareType t, Optional<SquareAttrib> attr) {
+  putSquare(pos, t, attr ? vector<SquareAttrib>({*attr}) : vector<SquareAttrib>());
 }
 
-void Level::Builder::putSquare(Vec2 pos, SquareType t, vector<SquareAttrib> at) {
-  putSquare(pos, SquareFactory::get(t), t, at);
+void Level::Builder::putSquare(Vec2 posT, SquareType t, vector<SquareAttrib> attr) {
+  Vec2 pos = transform(posT);
+  putType(pos, t, attr);
+  squares[pos].reset();
+  int view = getPrototype(t).floorView;
+  if (view > -1)
+    floorView[pos] = view;
 }
 
 void Level::Builder::putSquare(Vec2 pos, PSquare square, SquareType t, Optional<SquareAttrib> attr) {
@@ -450,13 +522,19 @@ void Level::Builder::putSquare(Vec2 pos, PSquare square, SquareType t, Optional<
 
 void Level::Builder::putSquare(Vec2 posT, PSquare square, SquareType t, vector<SquareAttrib> attr) {
   Vec2 pos = transform(posT);
-  CHECK(!contains({SquareType::UP_STAIRS, SquareType::DOWN_STAIRS}, type[pos])) << "Attempted to overwrite stairs";
+  putType(pos, t, attr);
   square->setPosition(pos);
-  if (squares[pos])
-    square->setBackground(squares[pos].get());
+  if (square->getViewObject().layer() == ViewLayer::FLOOR_BACKGROUND) {
+    floorView[pos] = floorViews.size();
+    floorViews.push_back(square->getViewObject());
+  }
   squares[pos] = std::move(square);
+}
+
+void Level::Builder::putType(Vec2 pos, SquareType t, const vector<SquareAttrib>& attr) {
+  CHECK(!contains({SquareType::UP_STAIRS, SquareType::DOWN_STAIRS}, type[pos])) << "Attempted to overwrite stairs";
   for (SquareAttrib at : attr)
-    attrib[pos].insert(at);
+    attrib[pos] |= attribBit(at);
   type[pos] = t;
 }
 
@@ -480,7 +558,7 @@ void Level::Builder::putCreature(Vec2 pos, PCreature creature) {
 
 bool Level::Builder::canPutCreature(Vec2 posT, Creature* c) {
   Vec2 pos = transform(posT);
-  if (!squares[pos]->canEnter(c))
+  if (!peekSquare(pos)->canEnter(c))
     return false;
   for (PCreature& c : creatures) {
     if (c->getPosition() == pos)
@@ -493,11 +571,36 @@ void Level::Builder::setMessage(const string& message) {
   entryMessage = message;
 }
 
-PLevel Level::Builder::build(Model* m, LevelMaker* maker) {
+void Level::Builder::addPopulation(function<void()> fun) {
+  if (populating)
+    fun();
+  else
+    population.push_back({mapStack, fun});
+}
+
+void Level::Builder::make(LevelMaker* maker) {
   CHECK(mapStack.empty());
   maker->make(this, squares.getBounds());
-  for (Vec2 v : heightMap.getBounds())
-    squares[v]->setHeight(heightMap[v]);
+  createSquares();
+}
+
+PLevel Level::Builder::build(Model* m, LevelMaker* maker) {
+  make(maker);
+  return build(m);
+}
+
+PLevel Level::Builder::build(Model* m) {
+  CHECK(mapStack.empty());
+  // The steps see the level through the same transformations as the makers that added them.
+  populating = true;
+  for (Population& step : population) {
+    mapStack = step.mapStack;
+    step.fun();
+  }
+  populating = false;
+  population.clear();
+  mapStack.clear();
+  createSquares();
   PLevel l(new Level(std::move(squares), m, locations, entryMessage, name, std::move(coverInfo)));
   for (PCreature& c : creatures) {
     Vec2 pos = c->getPosition();
@@ -506,37 +609,53 @@ PLevel Level::Builder::build(Model* m, LevelMaker* maker) {
   return l;
 }
 
-static Vec2::LinearMap identity() {
-  return [](Vec2 v) { return v; };
-}
-
-static Vec2::LinearMap deg90(Rectangle bounds) {
-  return [bounds](Vec2 v) {
-    v -= bounds.getTopLeft();
-    return bounds.getTopLeft() + Vec2(v.y, v.x);
-  };
+void Level::Builder::createSquares() {
+  for (Vec2 v : squares.getBounds()) {
+    if (!squares[v]) {
+      squares[v] = SquareFactory::get(type[v]);
+      squares[v]->setPosition(v);
+    }
+    // Only the last floor background matters, which is what putting the squares one over another would leave.
+    if (floorView[v] > -1)
+      squares[v]->setBackground(floorViews[floorView[v]]);
+    squares[v]->setHeight(heightMap[v]);
+  }
 }
 
-static Vec2::LinearMap deg180(Rectangle bounds) {
-  return [bounds](Vec2 v) {
-    return bounds.getTopLeft() - v + bounds.getBottomRight() - Vec2(1, 1);
-  };
+Vec2 Level::Builder::Transform::apply(Vec2 v) const {
+  return Vec2(xx * v.x + xy * v.y, yx * v.x + yy * v.y) + offset;
 }
 
-static Vec2::LinearMap deg270(Rectangle bounds) {
-  return [bounds](Vec2 v) {
-    v -= bounds.getTopRight() - Vec2(1, 0);
-    return bounds.getTopLeft() + Vec2(v.y, -v.x);
-  };
+Level::Builder::Transform Level::Builder::Transform::compose(const Transform& t) const {
+  Transform ret;
+  ret.xx = xx * t.xx + xy * t.yx;
+  ret.xy = xx * t.xy + xy * t.yy;
+  ret.yx = yx * t.xx + yy * t.yx;
+  ret.yy = yx * t.xy + yy * t.yy;
+  ret.offset = apply(t.offset);
+  return ret;
 }
 
 void Level::Builder::pushMap(Rectangle bounds, Rot rot) {
+  Vec2 topLeft = bounds.getTopLeft();
+  Vec2 bottomRight = bounds.getBottomRight();
+  Transform t;
   switch (rot) {
-    case CW0: mapStack.push_back(identity()); break;
-    case CW1: mapStack.push_back(deg90(bounds)); break;
-    case CW2: mapStack.push_back(deg180(bounds)); break;
-    case CW3: mapStack.push_back(deg270(bounds)); break;
+    case CW0: break;
+    case CW1:
+      t.xx = 0; t.xy = 1; t.yx = 1; t.yy = 0;
+      t.offset = Vec2(topLeft.x - topLeft.y, topLeft.y - topLeft.x);
+      break;
+    case CW2:
+      t.xx = -1; t.yy = -1;
+      t.offset = topLeft + bottomRight - Vec2(1, 1);
+      break;
+    case CW3:
+      t.xx = 0; t.xy = 1; t.yx = -1; t.yy = 0;
+      t.offset = Vec2(topLeft.x - topLeft.y, topLeft.y + bottomRight.x - 1);
+      break;
   }
+  mapStack.push_back(mapStack.empty() ? t : mapStack.back().compose(t));
 }
 
 void Level::Builder::popMap() {
@@ -544,10 +663,10 @@ void Level::Builder::popMap() {
 }
 
 Vec2 Level::Builder::transform(Vec2 v) {
-  for (auto m : reverse2(mapStack)) {
-    v = m(v);
-  }
-  return v;
+  if (mapStack.empty())
+    return v;
+  else
+    return mapStack.back().apply(v);
 }
 
 void Level::Builder::setCoverInfo(Vec2 pos, CoverInfo info) {
@@ -21,6 +21,8 @@
 #include "debug.h"
 #include "view.h"
 #include "field_of_view.h"
+#include "light_map.h"
+#include "poison_gas.h"
 #include "square_factory.h"
 #include "vision.h"
 
@@ -98,11 +100,21 @@ class Level {
 
   void replaceSquare(Vec2 pos, PSquare square);
 
-  /** The given square's method Square::tick() will be called every turn. */
+  /** The given square's method Square::tick() will be called every turn until Square::needsTicking()
+      returns false. */
   void addTickingSquare(Vec2 pos);
 
-  /** Returns all squares that must be ticked. */
-  vector<Square*> getTickingSquares() const;
+  /** Returns the number of squares that are ticked every turn. */
+  int getNumTickingSquares() const;
+
+  /** Ticks the ticking squares and spreads the poison gas. Called every turn.*/
+  void tick(double time);
+
+  /** Adds poison gas to the square.*/
+  void addPoisonGas(Vec2 pos, double amount);
+
+  /** Returns the amount of poison gas on the square.*/
+  double getPoisonGasAmount(Vec2 pos) const;
 
   /** Moves the creature to a different level according to \paramname{direction}. */
   void changeLevel(StairDirection direction, StairKey key, Creature* c);
@@ -174,6 +186,10 @@ class Level {
   /** Increases or decreases the number of light sources that emit on this square.*/
   void addLight(Vec2, double amount);
 
+  /** Recasts the light sources affected by squares changed since the last update. Changes are batched
+      until the light is read or the turn ends.*/
+  void updateLight() const;
+
   /** Class used to initialize a level object.*/
   class Builder {
     public:
@@ -183,9 +199,16 @@ class Level {
     /** Move constructor.*/
     Builder(Builder&&) = default;
 
-    /** Returns a given square.*/
+    /** Returns a given square. The square object is created on the first call, so use canEnter or getType for
+        read-only checks.*/
     Square* getSquare(Vec2);
 
+    /** Checks if the creature could enter the given square. Doesn't create the square object.*/
+    bool canEnter(Vec2, const Creature*);
+
+    /** Checks if the creature could enter the given square if it was unoccupied. Doesn't create the square object.*/
+    bool canEnterEmpty(Vec2, const Creature*);
+
     /** Checks if it's possible to put a creature on given square.*/
     bool canPutCreature(Vec2, Creature*);
 
@@ -195,8 +218,17 @@ class Level {
     /** Sets the message displayed when the player first enters the level.*/
     void setMessage(const string& message);
 
-    /** Builds the level. The level will keep reference to the model.
-        \paramname{surface} tells if this level is on the Earth surface.*/
+    /** Adds a step that creates creatures or items. These touch state shared by all levels, so the steps
+        are run by build, in the order they were added, after the rest of the level has been made.*/
+    void addPopulation(function<void()>);
+
+    /** Runs the maker, leaving out the population. Builders of different levels can do this in parallel.*/
+    void make(LevelMaker*);
+
+    /** Adds the population and builds the level. The level will keep reference to the model.*/
+    PLevel build(Model*);
+
+    /** Makes and builds the level.*/
     PLevel build(Model*, LevelMaker*);
 
     //@{
@@ -237,18 +269,46 @@ class Level {
     void popMap();
     
     private:
+    /** A rotation of a region composed with all the maps pushed before it.*/
+    struct Transform {
+      int xx = 1, xy = 0, yx = 0, yy = 1;
+      Vec2 offset;
+      Vec2 apply(Vec2) const;
+      /** Returns the map that applies the argument first and then this one.*/
+      Transform compose(const Transform&) const;
+    };
+    /** A square of every type used, kept for queries about squares that haven't been created.*/
+    struct Prototype {
+      PSquare square;
+      int floorView;
+    };
     Vec2 transform(Vec2);
+    const Prototype& getPrototype(SquareType);
+    const Square* peekSquare(Vec2 pos);
+    void putType(Vec2 pos, SquareType, const vector<SquareAttrib>&);
+    void createSquares();
+    /** Only squares that were put explicitly or requested with getSquare are kept here.
+        The rest are created from the type table by createSquares.*/
     Table<PSquare> squares;
+    Table<SquareType> type;
+    Table<unsigned> attrib;
+    /** Index into floorViews of the last floor background put on the square, or -1.*/
+    Table<int> floorView;
+    vector<ViewObject> floorViews;
+    map<SquareType, Prototype> prototypes;
     Table<double> heightMap;
-    Table<double> dark;
-    vector<Location*> locations;
     Table<CoverInfo> coverInfo;
-    Table<unordered_set<SquareAttrib>> attrib;
-    Table<SquareType> type;
+    vector<Location*> locations;
     vector<PCreature> creatures;
     string entryMessage;
     string name;
-    vector<Vec2::LinearMap> mapStack;
+    vector<Transform> mapStack;
+    struct Population {
+      vector<Transform> mapStack;
+      function<void()> fun;
+    };
+    vector<Population> population;
+    bool populating = false;
   };
 
   typedef unique_ptr<Builder> PBuilder;
@@ -260,7 +320,9 @@ class Level {
   Table<PSquare> SERIAL(squares);
   map<pair<StairDirection, StairKey>, vector<Vec2>> SERIAL(landingSquares);
   vector<Location*> SERIAL(locations);
-  vector<Square*> SERIAL(tickingSquares);
+  vector<Vec2> SERIAL(tickingSquares);
+  /** Index of each square in tickingSquares, or -1.*/
+  Table<int> tickingIndex;
   vector<Creature*> SERIAL(creatures);
   Model* SERIAL2(model, nullptr);
   mutable unordered_map<Vision*, FieldOfView> SERIAL(fieldOfView);
@@ -270,12 +332,13 @@ class Level {
   const Level* SERIAL2(backgroundLevel, nullptr);
   Vec2 SERIAL(backgroundOffset);
   Table<CoverInfo> SERIAL(coverInfo);
-  Table<double> SERIAL(lightAmount);
+  mutable LightMap SERIAL(lightMap);
+  PoisonGas SERIAL(poisonGas);
   
   Level(Table<PSquare> s, Model*, vector<Location*>, const string& message, const string& name,
       Table<CoverInfo> coverInfo);
 
-  void addLightSource(Vec2 pos, double radius, int numLight);
+  void removeTickingSquare(Vec2 pos);
   bool isWithinVision(Vec2 from, Vec2 to, Vision*) const;
   FieldOfView& getFieldOfView(Vision* vision) const;
   vector<Vec2> getVisibleTilesNoDarkness(Vec2 pos, Vision* vision) const;
@@ -113,7 +113,7 @@ class OrPredicates : public SquarePredicate {
 class DefaultCanEnter : public SquarePredicate {
   public:
   virtual bool apply(Level::Builder* builder, Vec2 pos) override {
-    return builder->getSquare(pos)->canEnter(Creature::getDefault());
+    return builder->canEnter(pos, Creature::getDefault());
   }
 };
 
@@ -223,7 +223,7 @@ class Connector : public LevelMaker {
     CHECKEQ((int) door.size(), 3);
   }
   double getValue(Level::Builder* builder, Vec2 pos, Rectangle area) {
-    if (builder->getSquare(pos)->canEnter(Creature::getDefault()))
+    if (builder->canEnter(pos, Creature::getDefault()))
       return 1;
     if (builder->hasAttrib(pos, SquareAttrib::LAKE))
       return 15;
@@ -234,7 +234,7 @@ class Connector : public LevelMaker {
     int numCorners = 0;
     int numTotal = 0;
     for (Vec2 v : Vec2::directions8())
-      if ((pos + v).inRectangle(area) && builder->getSquare(pos + v)->canEnter(Creature::getDefault())) {
+      if ((pos + v).inRectangle(area) && builder->canEnter(pos + v, Creature::getDefault())) {
         if (abs(v.x) == abs(v.y))
           ++numCorners;
         ++numTotal;
@@ -253,12 +253,12 @@ class Connector : public LevelMaker {
         Vec2::directions4(true), p1 ,p2);
     Vec2 prev(-100, -100);
     for (Vec2 v = p2; v != p1; v = path.getNextMove(v)) {
-      if (!builder->getSquare(v)->canEnter(Creature::getDefault())) {
+      if (!builder->canEnter(v, Creature::getDefault())) {
         char sym;
         SquareType newType = SquareType(0);
         SquareType oldType = builder->getType(v);
         if (isWall(oldType) && oldType != SquareType::BLACK_WALL)
-          newType = chooseRandom({
+          newType = chooseRandom<SquareType>({
               SquareType::PATH,
               SquareType::DOOR,
               SquareType::SECRET_PASS}, doorProb);
@@ -304,7 +304,7 @@ class Connector : public LevelMaker {
         connect(builder, p1, p2, area);
     }
     Dijkstra dijkstra(area, p1, 10000, [&] (Vec2 pos) {
-        if (builder->getSquare(pos)->canEnterEmpty(Creature::getDefault()))
+        if (builder->canEnterEmpty(pos, Creature::getDefault()))
           return 1.;
         else
           return ShortestPath::infinity;});
@@ -314,7 +314,7 @@ class Connector : public LevelMaker {
   }
   
   private:
-  initializer_list<double> doorProb;
+  vector<double> doorProb;
   double diggingCost;
   SquarePredicate* connectPred;
 };
@@ -361,19 +361,21 @@ class Creatures : public LevelMaker {
       cfactory(cf), numCreature(numC), actorFactory(actorF), squareType(type) {}
 
   virtual void make(Level::Builder* builder, Rectangle area) override {
-    Table<char> taken(area.getKX(), area.getKY());
-    for (int i : Range(numCreature)) {
-      PCreature creature = cfactory.random(actorFactory);
-      Vec2 pos;
-      int numTries = 100;
-      do {
-        pos = Vec2(Random.getRandom(area.getPX(), area.getKX()), Random.getRandom(area.getPY(), area.getKY()));
-      } while (--numTries > 0 && (!builder->canPutCreature(pos, creature.get())
-          || (squareType && builder->getType(pos) != *squareType)));
-      CHECK(numTries > 0) << "Failed to find square for creature";
-      builder->putCreature(pos, std::move(creature));
-      taken[pos] = 1;
-    }
+    builder->addPopulation([=] {
+      Table<char> taken(area.getKX(), area.getKY());
+      for (int i : Range(numCreature)) {
+        PCreature creature = cfactory.random(actorFactory);
+        Vec2 pos;
+        int numTries = 100;
+        do {
+          pos = Vec2(Random.getRandom(area.getPX(), area.getKX()), Random.getRandom(area.getPY(), area.getKY()));
+        } while (--numTries > 0 && (!builder->canPutCreature(pos, creature.get())
+            || (squareType && builder->getType(pos) != *squareType)));
+        CHECK(numTries > 0) << "Failed to find square for creature";
+        builder->putCreature(pos, std::move(creature));
+        taken[pos] = 1;
+      }
+    });
   }
 
   private:
@@ -389,14 +391,16 @@ class Items : public LevelMaker {
       factory(_factory), onType(_onType), minItem(minc), maxItem(maxc) {}
 
   virtual void make(Level::Builder* builder, Rectangle area) override {
-    int numItem = Random.getRandom(minItem, maxItem);
-    for (int i : Range(numItem)) {
-      Vec2 pos;
-      do {
-        pos = Vec2(Random.getRandom(area.getPX(), area.getKX()), Random.getRandom(area.getPY(), area.getKY()));
-      } while (builder->getType(pos) != onType);
-      builder->getSquare(pos)->dropItems(factory.random());
-    }
+    builder->addPopulation([=] {
+      int numItem = Random.getRandom(minItem, maxItem);
+      vector<Vec2> squares;
+      for (Vec2 v : area)
+        if (builder->getType(v) == onType)
+          squares.push_back(v);
+      CHECK(numItem == 0 || !squares.empty()) << "Failed to find square for items";
+      for (int i : Range(numItem))
+        builder->getSquare(squares[Random.getRandom(squares.size())])->dropItems(factory.random());
+    });
   }
 
   private:
@@ -817,63 +821,131 @@ class RandomLocations : public LevelMaker {
   }
 
   virtual void make(Level::Builder* builder, Rectangle area) override {
-    makeCnt(builder, area, 100);
+    // The squares don't change until the locations are chosen, so predicates are evaluated at most once
+    // per square, also across restarts.
+    map<SquarePredicate*, Table<char>> allowed;
+    for (SquarePredicate* pred : predicate)
+      if (!allowed.count(pred))
+        allowed.insert(make_pair(pred, Table<char>(area, 0)));
+    for (int i : Range(100))
+      if (tryMake(builder, area, allowed))
+        return;
+    FAIL << "Failed to find free space for " << (int)sizes.size() << " areas";
+  }
+
+  private:
+  static bool isAllowed(Level::Builder* builder, SquarePredicate* pred, Table<char>& cache, Vec2 pos) {
+    char& value = cache[pos];
+    if (value == 0)
+      value = pred->apply(builder, pos) ? 1 : 2;
+    return value == 1;
   }
 
-  void makeCnt(Level::Builder* builder, Rectangle area, int tries) {
+  // Returns the number of taken squares in every rectangle starting at the top-left corner of the area.
+  static Table<int> getSummedArea(const Table<bool>& taken, Rectangle area) {
+    Table<int> ret(Rectangle(area.getTopLeft(), area.getBottomRight() + Vec2(1, 1)), 0);
+    for (Vec2 v : area)
+      ret[v + Vec2(1, 1)] = int(taken[v]) + ret[v + Vec2(1, 0)] + ret[v + Vec2(0, 1)] - ret[v];
+    return ret;
+  }
+
+  static int getNumTaken(const Table<int>& sums, Rectangle r) {
+    return sums[r.getBottomRight()] - sums[r.getTopRight()] - sums[r.getBottomLeft()] + sums[r.getTopLeft()];
+  }
+
+  struct DistanceConstraint {
+    int index;
+    double minDist;
+    double maxDist;
+  };
+
+  // Places the locations one by one, each uniformly among all origins that satisfy the constraints.
+  // Returns false if a location doesn't fit, in which case the layout has to be started over.
+  bool tryMake(Level::Builder* builder, Rectangle area, map<SquarePredicate*, Table<char>>& allowed) {
     vector<Rectangle> occupied;
     vector<Rectangle> makerBounds;
     vector<Level::Builder::Rot> maps;
     for (int i : All(insideMakers))
       maps.push_back(chooseRandom(
             {Level::Builder::CW0, Level::Builder::CW1, Level::Builder::CW2, Level::Builder::CW3}));
+    Table<bool> taken(area, false);
     for (int i : All(insideMakers)) {
       int width = sizes[i].first;
       int height = sizes[i].second;
       if (contains({Level::Builder::CW1, Level::Builder::CW3}, maps[i]))
         std::swap(width, height);
       CHECK(width <= area.getW() && height <= area.getH());
-      int px;
-      int py;
-      int cnt = 1000;
-      bool ok;
-      do {
-        ok = true;
-        px = area.getPX() + Random.getRandom(area.getW() - width);
-        py = area.getPY() + Random.getRandom(area.getH() - height);
-        for (int j : Range(i))
-          if ((maxDistance.count({insideMakers[j], insideMakers[i]}) && 
-                maxDistance[{insideMakers[j], insideMakers[i]}] <
-                  Vec2(px + width / 2, py + height / 2).dist8(occupied[j].middle())) ||
-              minDistance[{insideMakers[j], insideMakers[i]}] >
-                  Vec2(px + width / 2, py + height / 2).dist8(occupied[j].middle())) {
-            ok = false;
-            break;
-          }
-        if (!predicate[i]->apply(builder, Vec2(px, py)) ||
-            !predicate[i]->apply(builder, Vec2(px + width - 1, py)) || 
-            !predicate[i]->apply(builder, Vec2(px + width - 1, py + height - 1)) || 
-            !predicate[i]->apply(builder, Vec2(px, py + height - 1))) 
-          ok = false;
-        else
-        if (separate)
-        for (Rectangle r : occupied)
-          if (r.intersects(Rectangle(px, py, px + width, py + height))) {
-            ok = false;
-            break;
-          }
-      } while (!ok && --cnt > 0);
-      if (cnt == 0) {
-        if (tries > 0) {
-          makeCnt(builder, area, tries - 1);
-          return;
+      vector<DistanceConstraint> constraints;
+      for (int j : Range(i)) {
+        pair<LevelMaker*, LevelMaker*> key(insideMakers[j], insideMakers[i]);
+        if (minDistance.count(key) || maxDistance.count(key))
+          constraints.push_back({j, minDistance.count(key) ? minDistance.at(key) : 0,
+              maxDistance.count(key) ? maxDistance.at(key) : 1000000});
+      }
+      SquarePredicate* pred = predicate[i];
+      Table<char>& cache = allowed.at(pred);
+      auto fits = [&] (Vec2 origin) {
+        if (!isAllowed(builder, pred, cache, origin) ||
+            !isAllowed(builder, pred, cache, origin + Vec2(width - 1, 0)) ||
+            !isAllowed(builder, pred, cache, origin + Vec2(width - 1, height - 1)) ||
+            !isAllowed(builder, pred, cache, origin + Vec2(0, height - 1)))
+          return false;
+        Vec2 center = origin + Vec2(width / 2, height / 2);
+        for (const DistanceConstraint& constraint : constraints) {
+          int dist = center.dist8(occupied[constraint.index].middle());
+          if (dist < constraint.minDist || dist > constraint.maxDist)
+            return false;
         }
-        else {
-          FAIL << "Failed to find free space for " << (int)sizes.size() << " areas";
+        return true;
+      };
+      // Origins whose center is within the maximum distances of the locations placed so far.
+      int minX = area.getPX(), minY = area.getPY();
+      int maxX = area.getKX() - width, maxY = area.getKY() - height;
+      for (const DistanceConstraint& constraint : constraints) {
+        Vec2 middle = occupied[constraint.index].middle();
+        int maxDist = min<double>(constraint.maxDist, 1000000);
+        minX = max(minX, middle.x - maxDist - width / 2);
+        minY = max(minY, middle.y - maxDist - height / 2);
+        maxX = min(maxX, middle.x + maxDist - width / 2 + 1);
+        maxY = min(maxY, middle.y + maxDist - height / 2 + 1);
+      }
+      if (minX >= maxX || minY >= maxY)
+        return false;
+      Optional<Vec2> origin;
+      // Most locations fit after a few random tries. This is as uniform as choosing from all valid origins.
+      for (int k : Range(100)) {
+        Vec2 v(Random.getRandom(minX, maxX), Random.getRandom(minY, maxY));
+        Rectangle bounds(v, v + Vec2(width, height));
+        bool ok = fits(v);
+        if (ok && separate)
+          for (Rectangle r : occupied)
+            if (r.intersects(bounds)) {
+              ok = false;
+              break;
+            }
+        if (ok) {
+          origin = v;
+          break;
         }
       }
-      occupied.push_back(Rectangle(px, py, px + width, py + height));
-      makerBounds.push_back(Rectangle(px, py, px + sizes[i].first, py + sizes[i].second));
+      if (!origin) {
+        // Otherwise all origins are checked, using the occupancy grid, so that a location that doesn't fit
+        // is detected right away.
+        Table<int> sums = getSummedArea(taken, area);
+        vector<Vec2> origins;
+        for (int px : Range(minX, maxX))
+          for (int py : Range(minY, maxY))
+            if ((!separate || getNumTaken(sums, Rectangle(px, py, px + width, py + height)) == 0)
+                && fits(Vec2(px, py)))
+              origins.push_back(Vec2(px, py));
+        if (origins.empty())
+          return false;
+        origin = origins[Random.getRandom(origins.size())];
+      }
+      occupied.push_back(Rectangle(*origin, *origin + Vec2(width, height)));
+      makerBounds.push_back(Rectangle(*origin, *origin + Vec2(sizes[i].first, sizes[i].second)));
+      for (Vec2 v : occupied.back())
+        taken[v] = true;
     }
     CHECK(insideMakers.size() == occupied.size());
     for (int i : All(insideMakers)) {
@@ -881,9 +953,9 @@ class RandomLocations : public LevelMaker {
       insideMakers[i]->make(builder, makerBounds[i]);
       builder->popMap();
     }
+    return true;
   }
 
-  private:
   vector<LevelMaker*> insideMakers;
   vector<pair<int, int>> sizes;
   vector<SquarePredicate*> predicate;
@@ -955,83 +1027,102 @@ class Shrine : public LevelMaker {
   LevelMaker* locationMaker;
 };
 
-void addAvg(int x, int y, const Table<double>& wys, double& avg, int& num) {
-  Vec2 pos(x, y);
-  if (pos.inRectangle(wys.getBounds())) {
-    avg += wys[pos];
-    ++num;
-  } 
-}
-
+// Diamond-square noise, computed in a flat buffer. The random numbers are drawn in the same order as before,
+// so the same seed gives the same map.
 Table<double> genNoiseMap(Rectangle area, vector<int> cornerLevels, double varianceMult) {
   int width = 1;
   while (width < area.getW() - 1 || width < area.getH() - 1)
     width *= 2;
   width /= 2;
   ++width;
-  Table<double> wys(width, width);
-  wys[0][0] = cornerLevels[0];
-  wys[width - 1][0] = cornerLevels[1];
-  wys[width - 1][width - 1] = cornerLevels[2];
-  wys[0][width - 1] = cornerLevels[3];
-  wys[(width - 1) / 2][(width - 1) / 2] = cornerLevels[4];
+  vector<double> wys(width * width);
+  auto at = [&wys, width] (int x, int y) -> double& { return wys[x * width + y]; };
+  at(0, 0) = cornerLevels[0];
+  at(width - 1, 0) = cornerLevels[1];
+  at(width - 1, width - 1) = cornerLevels[2];
+  at(0, width - 1) = cornerLevels[3];
+  at((width - 1) / 2, (width - 1) / 2) = cornerLevels[4];
 
   double variance = 0.5;
-  double heightDiff = 0.1;
   for (int a = width - 1; a >= 2; a /= 2) {
+    int n = (width - 1) / a;
+    int h = a / 2;
     if (a < width - 1)
-      for (Vec2 pos1 : Rectangle((width - 1) / a, (width - 1) / a)) {
-        Vec2 pos = pos1 * a;
-        double avg = (wys[pos] + wys[pos.x + a][pos.y] + wys[pos.x][pos.y + a] + wys[pos.x + a][pos.y + a]) / 4;
-        wys[pos.x + a / 2][pos.y + a / 2] =
-            avg + variance * (Random.getDouble() * 2 - 1);
+      for (int x = 0; x < n * a; x += a)
+        for (int y = 0; y < n * a; y += a) {
+          double avg = (at(x, y) + at(x + a, y) + at(x, y + a) + at(x + a, y + a)) / 4;
+          at(x + h, y + h) = avg + variance * (Random.getDouble() * 2 - 1);
+        }
+    // The neighbors outside of the map are skipped, summing in the same order as the full case.
+    for (int x = 0; x < n * a; x += a)
+      for (int y = 0; y <= n * a; y += a) {
+        double avg = 0;
+        int num = 2;
+        if (y > 0) {
+          avg += at(x + h, y - h);
+          ++num;
+        }
+        avg += at(x, y);
+        avg += at(x + a, y);
+        if (y < n * a) {
+          avg += at(x + h, y + h);
+          ++num;
+        }
+        at(x + h, y) = avg / num + variance * (Random.getDouble() * 2 - 1);
+      }
+    for (int x = 0; x <= n * a; x += a)
+      for (int y = 0; y < n * a; y += a) {
+        double avg = 0;
+        int num = 2;
+        if (x > 0) {
+          avg += at(x - h, y + h);
+          ++num;
+        }
+        avg += at(x, y);
+        avg += at(x, y + a);
+        if (x < n * a) {
+          avg += at(x + h, y + h);
+          ++num;
+        }
+        at(x, y + h) = avg / num + variance * (Random.getDouble() * 2 - 1);
       }
-    for (Vec2 pos1 : Rectangle((width - 1) / a, (width - 1) / a + 1)) {
-      Vec2 pos = pos1 * a;
-      double avg = 0;
-      int num = 0;
-      addAvg(pos.x + a / 2, pos.y - a / 2, wys, avg, num);
-      addAvg(pos.x, pos.y, wys, avg, num);
-      addAvg(pos.x + a, pos.y, wys, avg, num);
-      addAvg(pos.x + a / 2, pos.y + a / 2, wys, avg, num);
-      wys[pos.x + a / 2][pos.y] =
-          avg / num + variance * (Random.getDouble() * 2 - 1);
-    }
-    for (Vec2 pos1 : Rectangle((width - 1) / a + 1, (width - 1) / a)) {
-      Vec2 pos = pos1 * a;
-      double avg = 0;
-      int num = 0;
-      addAvg(pos.x - a / 2, pos.y + a / 2, wys, avg, num);
-      addAvg(pos.x, pos.y, wys, avg, num);
-      addAvg(pos.x, pos.y + a , wys, avg, num);
-      addAvg(pos.x + a / 2, pos.y + a / 2, wys, avg, num);
-      wys[pos.x][pos.y + a / 2] =
-          avg / num + variance * (Random.getDouble() * 2 - 1);
-    }
     variance *= varianceMult;
   }
+  vector<int> rows;
+  for (int y : Range(area.getH()))
+    rows.push_back(y * width / area.getH());
   Table<double> ret(area);
-  Vec2 offset(area.getPX(), area.getPY());
-  for (Vec2 v : area) {
-    Vec2 lv((v.x - offset.x) * width / area.getW(), (v.y - offset.y) * width / area.getH());
-    ret[v] = wys[lv];
+  for (int x : Range(area.getW())) {
+    const double* column = &wys[(x * width / area.getW()) * width];
+    auto row = ret[x + area.getPX()];
+    for (int y : Range(area.getH()))
+      row[y + area.getPY()] = column[rows[y]];
   }
   return ret;
 }
 
-vector<double> sortedValues(const Table<double>& t) {
+// Returns the values below which the given fractions of the table lie, without sorting all of it.
+vector<double> getCutOffs(const Table<double>& t, const vector<double>& ratios) {
   vector<double> values;
-  for (Vec2 v : t.getBounds()) {
+  values.reserve(t.getWidth() * t.getHeight());
+  for (Vec2 v : t.getBounds())
     values.push_back(t[v]);
+  vector<int> indexes;
+  for (double ratio : ratios)
+    indexes.push_back(ratio * double(values.size()));
+  vector<int> order(ratios.size());
+  for (int i : All(order))
+    order[i] = i;
+  sort(order.begin(), order.end(), [&] (int a, int b) { return indexes[a] < indexes[b]; });
+  vector<double> ret(ratios.size());
+  // Everything after a selected element is at least as big, so the next selection can skip what's before.
+  int selected = 0;
+  for (int i : order) {
+    nth_element(values.begin() + selected, values.begin() + indexes[i], values.end());
+    selected = indexes[i];
+    ret[i] = values[selected];
   }
-  sort(values.begin(), values.end());
-/*  vector<double> tmp(values);
-  unique(tmp.begin(), tmp.end());
-    string out;
-    for (double d : values)
-      out.append(convertToString(d) + " ");
-    Debug() << (int)tmp.size() << " unique values out of " << (int)values.size() << " " << out;*/
-  return values;
+  return ret;
 }
 
 class Mountains : public LevelMaker {
@@ -1041,58 +1132,65 @@ class Mountains : public LevelMaker {
       SquareType::SAND}) 
       : ratio(r), cornerLevels(_cornerLevels), types(_types), makeDark(_makeDark), varianceMult(varianceM) {
     CHECK(r.size() == 5);
+    CHECK(is_sorted(r.begin(), r.end())) << "Terrain ratios must be increasing";
   }
 
 
   virtual void make(Level::Builder* builder, Rectangle area) override {
     Table<double> wys = genNoiseMap(area, cornerLevels, varianceMult);
-    vector<double> values = sortedValues(wys);
-    double cutOffValSand = values[(int)(ratio[0] * double(values.size()))];
-    double cutOffValLand = values[(int)(ratio[1] * double(values.size()))];
-    double cutOffValHill = values[(int)(ratio[2] * double(values.size()))];
-    double cutOffVal = values[(int)(ratio[3] * double(values.size()))];
-    double cutOffValSnow = values[(int)(ratio[4] * double(values.size()))];
-    int gCnt = 0, mCnt = 0, hCnt = 0, lCnt = 0, sCnt = 0, wCnt = 0;
+    vector<double> cutOffs = getCutOffs(wys, ratio);
+    double cutOffVal = cutOffs[3];
+    double cutOffValSnow = cutOffs[4];
+    // First every square is classified by the number of cut offs below its height, from 0 for water
+    // up to 5 for glacier, which doesn't need any branches.
+    Table<char> terrain(area);
+    for (int x : Range(area.getPX(), area.getKX())) {
+      auto heights = wys[x];
+      auto classes = terrain[x];
+      for (int y : Range(area.getPY(), area.getKY())) {
+        double h = heights[y];
+        classes[y] = char((h > cutOffs[0]) + (h > cutOffs[1]) + (h > cutOffs[2]) + (h > cutOffs[3])
+            + (h > cutOffs[4]));
+      }
+    }
+    int cnt[6] = {0};
     for (Vec2 v : area) {
       builder->setHeightMap(v, wys[v]);
-      if (wys[v] > cutOffValSnow) {
-        builder->putSquare(v, types[2]);
-        builder->putSquare(v, types[0], SquareAttrib::GLACIER);
-        if (makeDark)
-          builder->setCoverInfo(v, {true, 0.0});
-        else
-          builder->addAttrib(v, SquareAttrib::ROAD_CUT_THRU);
-        ++gCnt;
-      }
-      else if (wys[v] > cutOffVal) {
-        builder->putSquare(v, types[2]);
-        builder->putSquare(v, types[1], SquareAttrib::MOUNTAIN);
-        if (makeDark)
-          builder->setCoverInfo(v, {true, 1. - (wys[v] - cutOffVal) / (cutOffValSnow - cutOffVal)});
-        else
-          builder->addAttrib(v, SquareAttrib::ROAD_CUT_THRU);
-        ++mCnt;
-      }
-      else if (wys[v] > cutOffValHill) {
-        builder->putSquare(v, types[2], SquareAttrib::HILL);
-        ++hCnt;
-      }
-      else if (wys[v] > cutOffValLand) {
-        builder->putSquare(v, types[3]);
-        builder->addAttrib(v, SquareAttrib::LOWLAND);
-        ++lCnt;
-      }
-      else if (wys[v] > cutOffValSand) {
-        builder->putSquare(v, types[4]);
-        builder->addAttrib(v, SquareAttrib::LOWLAND);
-        ++sCnt;
-      }
-      else {
-        builder->addAttrib(v, SquareAttrib::LAKE);
-        ++wCnt;
+      ++cnt[int(terrain[v])];
+      switch (terrain[v]) {
+        case 5:
+          builder->putSquare(v, types[2]);
+          builder->putSquare(v, types[0], SquareAttrib::GLACIER);
+          if (makeDark)
+            builder->setCoverInfo(v, {true, 0.0});
+          else
+            builder->addAttrib(v, SquareAttrib::ROAD_CUT_THRU);
+          break;
+        case 4:
+          builder->putSquare(v, types[2]);
+          builder->putSquare(v, types[1], SquareAttrib::MOUNTAIN);
+          if (makeDark)
+            builder->setCoverInfo(v, {true, 1. - (wys[v] - cutOffVal) / (cutOffValSnow - cutOffVal)});
+          else
+            builder->addAttrib(v, SquareAttrib::ROAD_CUT_THRU);
+          break;
+        case 3:
+          builder->putSquare(v, types[2], SquareAttrib::HILL);
+          break;
+        case 2:
+          builder->putSquare(v, types[3]);
+          builder->addAttrib(v, SquareAttrib::LOWLAND);
+          break;
+        case 1:
+          builder->putSquare(v, types[4]);
+          builder->addAttrib(v, SquareAttrib::LOWLAND);
+          break;
+        default:
+          builder->addAttrib(v, SquareAttrib::LAKE);
+          break;
       }
     }
-    Debug() << "Terrain distribution " << gCnt << " glacier, " << mCnt << " mountain, " << hCnt << " hill, " << lCnt << " lowland, " << wCnt << " water, " << sCnt << " sand";
+    Debug() << "Terrain distribution " << cnt[5] << " glacier, " << cnt[4] << " mountain, " << cnt[3] << " hill, " << cnt[2] << " lowland, " << cnt[0] << " water, " << cnt[1] << " sand";
   }
 
   private:
@@ -1108,42 +1206,101 @@ class Roads : public LevelMaker {
   Roads(SquareType roadSquare) : square(roadSquare) {}
 
   double getValue(Level::Builder* builder, Vec2 pos) {
-    if ((!builder->getSquare(pos)->canEnter(Creature::getDefault()) && 
+    if ((!builder->canEnter(pos, Creature::getDefault()) && 
          !builder->hasAttrib(pos, SquareAttrib::ROAD_CUT_THRU)) ||
         builder->hasAttrib(pos, SquareAttrib::NO_ROAD))
       return ShortestPath::infinity;
     SquareType type = builder->getType(pos);
     if (contains({SquareType::ROAD, SquareType::ROAD}, type))
       return 1;
-    return 1 + pow(1 + builder->getHeightMap(pos), 2);
+    double height = 1 + builder->getHeightMap(pos);
+    return 1 + height * height;
   }
 
+  // Grows the network from the first point like Prim's algorithm. Every step is an A* search from all squares
+  // of the network to the closest point that isn't connected yet, and the path found joins the network.
+  // The costs of squares are computed once, when the first search reaches them.
   virtual void make(Level::Builder* builder, Rectangle area) override {
-    vector<Vec2> points;
+    vector<Vec2> remaining;
     for (Vec2 v : area)
       if (builder->hasAttrib(v, SquareAttrib::CONNECT_ROAD)) {
-        points.push_back(v);
+        remaining.push_back(v);
         Debug() << "Connecting point " << v;
       }
-    for (int ind : Range(1, points.size())) {
-      Vec2 p1 = points[ind];
-      Vec2 p2 = points[ind - 1];
-      ShortestPath path(area,
-          [builder, this, &area](Vec2 pos) { return getValue(builder, pos); }, 
-          [] (Vec2 v) { return v.length4(); },
-          Vec2::directions4(true), p1 ,p2);
-      Vec2 prev(-1, -1);
-      for (Vec2 v = p2; v != p1; v = path.getNextMove(v)) {
-        SquareType roadType = SquareType::ROAD;
-        if (v != p2 && v != p1 && builder->getType(v) != roadType)
-          builder->putSquare(v, roadType);
-        if (prev.x > -1)
-          builder->getSquare(v)->addTravelDir(prev - v);
-        builder->getSquare(v)->addTravelDir(path.getNextMove(v) - v);
-        prev = v;
+    if (remaining.size() < 2)
+      return;
+    Table<double> cost(area, -1);
+    Table<bool> isPoint(area, false);
+    for (Vec2 v : remaining)
+      isPoint[v] = true;
+    vector<Vec2> network {remaining[0]};
+    remaining.erase(remaining.begin());
+    vector<Vec2> directions = Vec2::directions4(true);
+    Table<double> distance(area);
+    Table<int> parent(area);
+    Table<int> searchId(area, -1);
+    // Elements are (distance + estimate, distance, position).
+    typedef tuple<double, double, Vec2> QueueElem;
+    auto cmp = [](const QueueElem& a, const QueueElem& b) { return get<0>(a) > get<0>(b); };
+    auto estimate = [&] (Vec2 v) {
+      int ret = 1000000;
+      for (Vec2 p : remaining)
+        ret = min(ret, (p - v).length4());
+      return ret;
+    };
+    set<pair<Vec2, Vec2>> links;
+    for (int id = 0; !remaining.empty(); ++id) {
+      priority_queue<QueueElem, vector<QueueElem>, decltype(cmp)> queue(cmp);
+      for (Vec2 v : network) {
+        searchId[v] = id;
+        distance[v] = 0;
+        parent[v] = -1;
+        queue.push(make_tuple(estimate(v), 0, v));
+      }
+      Optional<Vec2> found;
+      while (!queue.empty()) {
+        double dist = get<1>(queue.top());
+        Vec2 pos = get<2>(queue.top());
+        queue.pop();
+        if (dist > distance[pos])
+          continue;
+        if (isPoint[pos] && contains(remaining, pos)) {
+          found = pos;
+          break;
+        }
+        for (int i : All(directions)) {
+          Vec2 next = pos + directions[i];
+          if (!next.inRectangle(area))
+            continue;
+          if (cost[next] < 0)
+            cost[next] = getValue(builder, next);
+          if (cost[next] == ShortestPath::infinity)
+            continue;
+          if (searchId[next] != id || dist + cost[next] < distance[next]) {
+            searchId[next] = id;
+            distance[next] = dist + cost[next];
+            parent[next] = i;
+            queue.push(make_tuple(distance[next] + estimate(next), distance[next], next));
+          }
+        }
+      }
+      if (!found) {
+        Debug() << "Couldn't connect " << int(remaining.size()) << " road points";
+        break;
+      }
+      removeElement(remaining, *found);
+      for (Vec2 pos = *found; parent[pos] > -1;) {
+        Vec2 prev = pos - directions[parent[pos]];
+        links.insert({pos, prev});
+        links.insert({prev, pos});
+        if (!isPoint[pos] && builder->getType(pos) != SquareType::ROAD)
+          builder->putSquare(pos, SquareType::ROAD);
+        network.push_back(pos);
+        pos = prev;
       }
-      builder->getSquare(p1)->addTravelDir(prev - p1);
     }
+    for (auto& link : links)
+      builder->getSquare(link.first)->addTravelDir(link.second - link.first);
   }
 
   private:
@@ -1173,8 +1330,7 @@ class Forrest : public LevelMaker {
 
   virtual void make(Level::Builder* builder, Rectangle area) override {
     Table<double> wys = genNoiseMap(area, {0, 0, 0, 0, 0}, 0.9);
-    vector<double> values = sortedValues(wys);
-    double cutoff = values[values.size() * ratio];
+    double cutoff = getCutOffs(wys, {ratio})[0];
     for (Vec2 v : area)
       if (builder->getType(v) == onType && wys[v] < cutoff) {
         if (Random.getDouble() <= density)
@@ -1298,17 +1454,19 @@ class ShopMaker : public LevelMaker {
   virtual void make(Level::Builder* builder, Rectangle area) override {
     Location *loc = new Location();
     builder->addLocation(loc, area);
-    PCreature shopkeeper = CreatureFactory::getShopkeeper(loc, tribe);
-    vector<Vec2> pos;
-    for (Vec2 v : area)
-      if (builder->getSquare(v)->canEnter(shopkeeper.get()) && builder->getType(v) == building.floorInside)
-        pos.push_back(v);
-    builder->putCreature(pos[Random.getRandom(pos.size())], std::move(shopkeeper));
-    builder->putSquare(pos[Random.getRandom(pos.size())], SquareType::TORCH);
-    for (int i : Range(numItems)) {
-      Vec2 v = pos[Random.getRandom(pos.size())];
-      builder->getSquare(v)->dropItems(factory.random());
-    }
+    builder->addPopulation([=] {
+      PCreature shopkeeper = CreatureFactory::getShopkeeper(loc, tribe);
+      vector<Vec2> pos;
+      for (Vec2 v : area)
+        if (builder->canEnter(v, shopkeeper.get()) && builder->getType(v) == building.floorInside)
+          pos.push_back(v);
+      builder->putCreature(pos[Random.getRandom(pos.size())], std::move(shopkeeper));
+      builder->putSquare(pos[Random.getRandom(pos.size())], SquareType::TORCH);
+      for (int i : Range(numItems)) {
+        Vec2 v = pos[Random.getRandom(pos.size())];
+        builder->getSquare(v)->dropItems(factory.random());
+      }
+    });
   }
 
   private:
@@ -1411,16 +1569,18 @@ class Circle : public LevelMaker {
   Circle(ItemId _item) : item(_item) {}
 
   virtual void make(Level::Builder* builder, Rectangle area) override {
-    Vec2 center = area.middle();
-    double r = min(area.getH(), area.getW()) / 2 - 1;
-    Vec2 lastPos;
-    for (double a = 0; a < 3.1415 * 2; a += Random.getDouble() * r / 10) {
-      Vec2 pos = center + Vec2(sin(a) * r, cos(a) * r);
-      if (pos != lastPos) {
-        builder->getSquare(pos)->dropItem(ItemFactory::fromId(item));
-        lastPos = pos;
+    builder->addPopulation([=] {
+      Vec2 center = area.middle();
+      double r = min(area.getH(), area.getW()) / 2 - 1;
+      Vec2 lastPos;
+      for (double a = 0; a < 3.1415 * 2; a += Random.getDouble() * r / 10) {
+        Vec2 pos = center + Vec2(sin(a) * r, cos(a) * r);
+        if (pos != lastPos) {
+          builder->getSquare(pos)->dropItem(ItemFactory::fromId(item));
+          lastPos = pos;
+        }
       }
-    }
+    });
   }
 
   private:
@@ -1463,8 +1623,10 @@ class CastleExit : public LevelMaker {
     for (Vec2 pos : guardPos) {
       Location* guard = new Location();
       builder->addLocation(guard, Rectangle(loc + pos, loc + pos + Vec2(1, 1)));
-      builder->putCreature(loc + pos, CreatureFactory::fromId(guardId, guardTribe,
-            MonsterAIFactory::stayInLocation(guard, false)));
+      builder->addPopulation([=] {
+        builder->putCreature(loc + pos, CreatureFactory::fromId(guardId, guardTribe,
+              MonsterAIFactory::stayInLocation(guard, false)));
+      });
     }
   }
 
@@ -2085,3 +2247,13 @@ LevelMaker* LevelMaker::grassAndTrees() {
   queue->addMaker(new Forrest(0.8, 0.5, SquareType::GRASS, {SquareType::CANIF_TREE}, {1}));
   return new BorderGuard(queue, SquareType::BLACK_WALL);
 }
+
+LevelMaker* LevelMaker::terrain() {
+  MakerQueue* queue = new MakerQueue();
+  queue->addMaker(new Empty(SquareType::WATER));
+  queue->addMaker(new Mountains({0.0, 0.0, 0.5, 0.66, 0.9}, 0.5, {0, 1, 0, 0, 0}, true,
+        {SquareType::MOUNTAIN2, SquareType::MOUNTAIN2, SquareType::HILL, SquareType::GRASS, SquareType::SAND}));
+  queue->addMaker(new Forrest(0.7, 0.5, SquareType::GRASS, {SquareType::CANIF_TREE}, {1}));
+  queue->addMaker(new Forrest(0.4, 0.5, SquareType::HILL, {SquareType::DECID_TREE}, {1}));
+  return queue;
+}
@@ -55,6 +55,9 @@ class LevelMaker {
   static LevelMaker* towerLevel(Optional<StairKey> down, Optional<StairKey> up);
   static Vec2 getRandomExit(Rectangle rect, int minCornerDist = 1);
   static LevelMaker* grassAndTrees();
+
+  /** The mountains, lakes and forests of the keeper's world, without any settlements.*/
+  static LevelMaker* terrain();
 };
 
 #endif
@@ -0,0 +1,107 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "light_map.h"
+#include "field_of_view.h"
+#include "vision.h"
+
+template <class Archive> 
+void LightMap::serialize(Archive& ar, const unsigned int version) {
+  ar& SVAR(squares)
+    & SVAR(amount)
+    & SVAR(sources)
+    & SVAR(dirty);
+  CHECK_SERIAL;
+}
+
+SERIALIZABLE(LightMap);
+
+template <class Archive> 
+void LightMap::Source::serialize(Archive& ar, const unsigned int version) {
+  ar& SVAR(radius)
+    & SVAR(footprint)
+    & SVAR(dirty);
+  CHECK_SERIAL;
+}
+
+SERIALIZABLE(LightMap::Source);
+
+LightMap::LightMap(const Table<PSquare>& s) : squares(&s), amount(s.getBounds(), 0) {
+}
+
+void LightMap::setSource(Vec2 pos, double radius) {
+  auto it = sources.find(pos);
+  if (it != sources.end()) {
+    if (it->second.radius == radius)
+      return;
+    it->second.radius = radius;
+    it->second.dirty = true;
+  } else if (radius > 0)
+    sources.emplace(pos, Source(radius));
+  else
+    return;
+  dirty = true;
+}
+
+void LightMap::squareChanged(Vec2 pos) {
+  for (auto& elem : sources)
+    if (!elem.second.dirty && (elem.first - pos).lengthD() <= elem.second.radius) {
+      elem.second.dirty = true;
+      dirty = true;
+    }
+}
+
+void LightMap::cast(Vec2 pos, Source& source) {
+  for (auto& elem : source.footprint)
+    amount[elem.first] -= elem.second;
+  source.footprint.clear();
+  if (source.radius > 0)
+    for (Vec2 v : FieldOfView::getVisibleTiles(*squares, Vision::get(VisionId::NORMAL), pos,
+          (int) ceil(source.radius))) {
+      double dist = (v - pos).lengthD();
+      if (dist <= source.radius) {
+        double light = min(1.0, 1 - dist / source.radius);
+        amount[v] += light;
+        source.footprint.emplace_back(v, light);
+      }
+    }
+  source.dirty = false;
+}
+
+void LightMap::update() {
+  if (!dirty)
+    return;
+  PROFILE("LightMap::update");
+  for (auto it = sources.begin(); it != sources.end();)
+    if (it->second.dirty) {
+      cast(it->first, it->second);
+      if (it->second.radius > 0)
+        ++it;
+      else
+        it = sources.erase(it);
+    } else
+      ++it;
+  dirty = false;
+}
+
+double LightMap::getLight(Vec2 pos) const {
+  return amount[pos];
+}
+
+void LightMap::addLight(Vec2 pos, double num) {
+  amount[pos] += num;
+}
@@ -0,0 +1,62 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _LIGHT_MAP_H
+#define _LIGHT_MAP_H
+
+#include "util.h"
+
+class Square;
+
+/** Keeps the amount of light emitted by light sources on each square of a level. Every source remembers
+  * the squares it lights, so when a square changes only the sources within their radius of it are recast,
+  * and each of them only looks as far as its own radius.*/
+class LightMap {
+  public:
+  LightMap(const Table<PSquare>& squares);
+
+  /** Sets the radius of the light emitted from the given square. A radius of 0 removes the source.*/
+  void setSource(Vec2 pos, double radius);
+
+  /** Marks the sources that might light differently after the square has changed.*/
+  void squareChanged(Vec2 pos);
+
+  /** Recasts the light of the sources that were changed since the last update.*/
+  void update();
+
+  /** Returns the amount of light emitted on the square. Requires an update after any change.*/
+  double getLight(Vec2 pos) const;
+
+  /** Increases or decreases the light on the square independently of the sources.*/
+  void addLight(Vec2 pos, double amount);
+
+  SERIALIZATION_DECL(LightMap);
+
+  private:
+  struct Source {
+    Source(double r) : radius(r), dirty(true) {}
+    double SERIAL(radius);
+    vector<pair<Vec2, double>> SERIAL(footprint);
+    bool SERIAL(dirty);
+    SERIALIZATION_DECL(Source);
+  };
+  void cast(Vec2 pos, Source&);
+  const Table<PSquare>* SERIAL(squares);
+  Table<double> SERIAL(amount);
+  map<Vec2, Source> SERIAL(sources);
+  bool SERIAL2(dirty, false);
+};
+
+#endif
@@ -37,6 +37,12 @@
 #include "gui_elem.h"
 #include "music.h"
 #include "test.h"
+#include "keeper_stress.h"
+#include "render_benchmark.h"
+#include "random_benchmark.h"
+#include "terrain_benchmark.h"
+#include "gas_benchmark.h"
+#include "window_view.h"
 
 using namespace boost::iostreams;
 
@@ -150,11 +156,78 @@ static void saveExceptionLine(const string& path, const string& line) {
   of << line << std::endl;
 }
 
+static void initializeGame() {
+  Item::identifyEverything();
+  Quest::clearAll();
+  Creature::initialize();
+  Tribe::clearAll();
+  Technology::clearAll();
+  Skill::clearAll();
+  Vision::clearAll();
+  EventListener::initialize();
+  Tribe::init();
+  Skill::init();
+  Technology::init();
+  Statistics::init();
+  Vision::init();
+  NameGenerator::init("first_names.txt", "aztec_names.txt", "creatures.txt",
+      "artifacts.txt", "world.txt", "town_names.txt", "dwarfs.txt", "gods.txt", "demons.txt", "dogs.txt",
+      "insults.txt");
+  ItemFactory::init();
+}
+
 int main(int argc, char* argv[]) {
   if (argc == 2 && !strcmp(argv[1], "test")) {
     testAll();
     return 0;
   }
+  if (argc >= 7 && !strcmp(argv[1], "stress")) {
+    Debug::init();
+    Options::init("options.txt");
+    Random.init(argc > 7 ? convertFromString<int>(argv[7]) : 0);
+    initializeGame();
+    KeeperStress stress({convertFromString<int>(argv[2]), convertFromString<int>(argv[3]),
+        convertFromString<int>(argv[4]), convertFromString<int>(argv[5]), convertFromString<int>(argv[6])});
+    stress.run();
+    stress.printResults(std::cout);
+    return 0;
+  }
+  if (argc >= 2 && !strcmp(argv[1], "randbench")) {
+    Debug::init();
+    RandomBenchmark benchmark(argc > 2 ? convertFromString<int>(argv[2]) : 10000000);
+    benchmark.run();
+    benchmark.printResults(std::cout);
+    return 0;
+  }
+  if (argc >= 2 && !strcmp(argv[1], "terrainbench")) {
+    Debug::init();
+    TerrainBenchmark benchmark({500, 800}, argc > 2 ? convertFromString<int>(argv[2]) : 5);
+    benchmark.run();
+    benchmark.printResults(std::cout);
+    return 0;
+  }
+  if (argc >= 2 && !strcmp(argv[1], "gasbench")) {
+    Debug::init();
+    GasBenchmark benchmark(argc > 2 ? convertFromString<int>(argv[2]) : 400,
+        argc > 3 ? convertFromString<int>(argv[3]) : 2000);
+    benchmark.run();
+    benchmark.printResults(std::cout);
+    return 0;
+  }
+  if (argc >= 3 && !strcmp(argv[1], "bench")) {
+    Debug::init();
+    Options::init("options.txt");
+    initializeGame();
+    WindowView view;
+    view.initialize();
+    GuiElem::initialize("frame.png");
+    unique_ptr<Model> model = loadGame(argv[2], false);
+    model->setView(&view);
+    RenderBenchmark benchmark(argc > 3 ? convertFromString<int>(argv[3]) : 100);
+    benchmark.run(view, *model);
+    benchmark.printResults(std::cout);
+    return 0;
+  }
   unique_ptr<View> view;
   ifstream input;
   ofstream output;
@@ -202,23 +275,7 @@ int main(int argc, char* argv[]) {
   view->setJukebox(&jukebox);
   GuiElem::initialize("frame.png");
   while (1) {
-    Item::identifyEverything();
-    Quest::clearAll();
-    Creature::initialize();
-    Tribe::clearAll();
-    Technology::clearAll();
-    Skill::clearAll();
-    Vision::clearAll();
-    EventListener::initialize();
-    Tribe::init();
-    Skill::init();
-    Technology::init();
-    Statistics::init();
-    Vision::init();
-    NameGenerator::init("first_names.txt", "aztec_names.txt", "creatures.txt",
-        "artifacts.txt", "world.txt", "town_names.txt", "dwarfs.txt", "gods.txt", "demons.txt", "dogs.txt",
-        "insults.txt");
-    ItemFactory::init();
+    initializeGame();
     bool modelReady = false;
     messageBuffer.initialize(view.get());
     view->reset();
@@ -25,7 +25,8 @@
 
 using namespace colors;
 
-MapGui::MapGui(const Table<Optional<ViewIndex>>& o, function<void(Vec2)> fun) : objects(o), leftClickFun(fun) {
+MapGui::MapGui(const Table<Optional<ViewIndex>>& o, function<void(Vec2)> fun)
+    : objects(o), tileInfo(o.getBounds(), {0, 0, false}), leftClickFun(fun) {
 }
 
 void MapGui::setLayout(MapLayout* l) {
@@ -43,6 +44,9 @@ Optional<Vec2> MapGui::getHighlightedTile(WindowRenderer& renderer) {
   return layout->projectOnMap(getBounds(), pos);
 }
 
+// used instead of the game's Random, which belongs to the game thread
+static RandomGen flickerRandom;
+
 static Color getBleedingColor(const ViewObject& object) {
   double bleeding = object.getBleeding();
  /* if (object.isPoisoned())
@@ -52,14 +56,19 @@ static Color getBleedingColor(const ViewObject& object) {
   return Color(255, max(0., (1 - bleeding) * 255), max(0., (1 - bleeding) * 255));
 }
 
-Color getHighlightColor(ViewIndex::HighlightInfo info) {
-  switch (info.type) {
+// darkening highlights go first, so selections stay bright
+static vector<HighlightType> highlightOrder {HighlightType::MEMORY, HighlightType::NIGHT,
+    HighlightType::POISON_GAS, HighlightType::FOG, HighlightType::BUILD, HighlightType::RECT_SELECTION};
+
+Color getHighlightColor(HighlightType type, double amount) {
+  switch (type) {
     case HighlightType::BUILD: return transparency(yellow, 170);
     case HighlightType::RECT_SELECTION: return transparency(yellow, 90);
-    case HighlightType::FOG: return transparency(white, 120 * info.amount);
-    case HighlightType::POISON_GAS: return Color(0, min(255., info.amount * 500), 0, info.amount * 140);
+    case HighlightType::FOG: return transparency(white, 120 * amount);
+    case HighlightType::POISON_GAS: return Color(0, min(255., amount * 500), 0, amount * 140);
     case HighlightType::MEMORY: return transparency(black, 80);
-    case HighlightType::NIGHT: return transparency(nightBlue, info.amount * 160);
+    case HighlightType::NIGHT: return transparency(nightBlue, amount * 160);
+    END_CASE(HighlightType);
   }
   FAIL << "pokpok";
   return black;
@@ -72,10 +81,7 @@ enum class ConnectionId {
   MOUNTAIN2,
 };
 
-unordered_map<Vec2, ConnectionId> floorIds;
-set<Vec2> shadowed;
-
-Optional<ConnectionId> getConnectionId(ViewId id) {
+static Optional<ConnectionId> getConnectionId(ViewId id) {
   switch (id) {
     case ViewId::ROAD: return ConnectionId::ROAD;
     case ViewId::BLACK_WALL:
@@ -93,9 +99,11 @@ Optional<ConnectionId> getConnectionId(ViewId id) {
   }
 }
 
-bool tileConnects(ConnectionId id, Vec2 pos) {
-  return floorIds.count(pos) && id == floorIds.at(pos);
-}
+static const vector<pair<Vec2, int>> connectionDirs {
+  {Vec2(0, -1), Tile::getConnectionBit(Dir::N)},
+  {Vec2(0, 1), Tile::getConnectionBit(Dir::S)},
+  {Vec2(1, 0), Tile::getConnectionBit(Dir::E)},
+  {Vec2(-1, 0), Tile::getConnectionBit(Dir::W)}};
 
 void MapGui::onLeftClick(Vec2 v) {
   if (optionsGui && v.inRectangle(optionsGui->getBounds()))
@@ -164,12 +172,16 @@ Optional<ViewObject> MapGui::drawObjectAbs(Renderer& renderer, int x, int y, con
       int sz = Renderer::tileSize[tile.getTexNum()];
       int width = sizeX - 2 * off;
       int height = sizeY - 2 * off;
-      set<Dir> dirs;
-      if (auto connectionId = getConnectionId(object.id()))
-        for (Vec2 dir : Vec2::directions4())
-          if (tileConnects(*connectionId, tilePos + dir))
-            dirs.insert(dir.getCardinalDir());
-      Vec2 coord = tile.getSpriteCoord(dirs);
+      int connections = 0;
+      if (auto connectionId = getConnectionId(object.id())) {
+        const TileInfo& info = tileInfo[tilePos];
+        // the mask is precomputed for the floor, other layers are rare enough to work it out here
+        if (info.connectionId == int(*connectionId) + 1)
+          connections = info.connections;
+        else
+          connections = getConnections(tilePos, int(*connectionId) + 1);
+      }
+      Vec2 coord = tile.getSpriteCoord(connections);
 
       if (object.hasModifier(ViewObject::MOVE_UP))
         moveY = -6;
@@ -180,10 +192,10 @@ Optional<ViewObject> MapGui::drawObjectAbs(Renderer& renderer, int x, int y, con
       renderer.drawSprite(x + off, y + moveY + off, coord.x * sz,
           coord.y * sz, sz, sz, Renderer::tiles[tile.getTexNum()], width, height, color);
       if (contains({ViewLayer::FLOOR, ViewLayer::FLOOR_BACKGROUND}, object.layer()) && 
-          shadowed.count(tilePos) && !tile.stickingOut)
+          tileInfo[tilePos].shadowed && !tile.stickingOut)
         renderer.drawSprite(x, y, 1 * Renderer::nominalSize, 21 * Renderer::nominalSize, Renderer::nominalSize, Renderer::nominalSize, Renderer::tiles[5], width, height);
       if (object.getBurning() > 0) {
-        renderer.drawSprite(x, y, Random.getRandom(10, 12) * Renderer::nominalSize, 0 * Renderer::nominalSize,
+        renderer.drawSprite(x, y, flickerRandom.getRandom(10, 12) * Renderer::nominalSize, 0 * Renderer::nominalSize,
             Renderer::nominalSize, Renderer::nominalSize, Renderer::tiles[2], width, height);
       }
       if (object.hasModifier(ViewObject::LOCKED))
@@ -213,21 +225,70 @@ void MapGui::setLevelBounds(Rectangle b) {
   levelBounds = b;
 }
 
-void MapGui::updateObjects(const MapMemory* mem) {
-  lastMemory = mem;
-  floorIds.clear();
-  shadowed.clear();
-  for (Vec2 wpos : layout->getAllTiles(getBounds(), objects.getBounds()))
-    if (auto& index = objects[wpos])
-      if (index->hasObject(ViewLayer::FLOOR)) {
-        ViewObject object = index->getObject(ViewLayer::FLOOR);
-        if (object.hasModifier(ViewObject::CASTS_SHADOW)) {
-          shadowed.erase(wpos);
-          shadowed.insert(wpos + Vec2(0, 1));
-        }
-        if (auto id = getConnectionId(object.id()))
-          floorIds.insert(make_pair(wpos, *id));
-      }
+bool MapGui::castsShadow(Vec2 pos) const {
+  if (!pos.inRectangle(objects.getBounds()))
+    return false;
+  auto& index = objects[pos];
+  return index && index->hasObject(ViewLayer::FLOOR)
+      && index->getObject(ViewLayer::FLOOR).hasModifier(ViewObject::CASTS_SHADOW);
+}
+
+int MapGui::getFloorConnection(Vec2 pos) const {
+  if (auto& index = objects[pos])
+    if (index->hasObject(ViewLayer::FLOOR))
+      if (auto id = getConnectionId(index->getObject(ViewLayer::FLOOR).id()))
+        return int(*id) + 1;
+  return 0;
+}
+
+int MapGui::getConnections(Vec2 pos, int connectionId) const {
+  int ret = 0;
+  for (auto& dir : connectionDirs) {
+    Vec2 v = pos + dir.first;
+    if (v.inRectangle(tileInfo.getBounds()) && tileInfo[v].connectionId == connectionId)
+      ret |= dir.second;
+  }
+  return ret;
+}
+
+void MapGui::updateConnections(Vec2 pos) {
+  TileInfo& info = tileInfo[pos];
+  info.connections = info.connectionId ? getConnections(pos, info.connectionId) : 0;
+}
+
+void MapGui::updateShadow(Vec2 pos) {
+  if (pos.inRectangle(tileInfo.getBounds()))
+    tileInfo[pos].shadowed = castsShadow(pos - Vec2(0, 1)) && !castsShadow(pos);
+}
+
+void MapGui::updateObjects(const MapMemory* mem, const vector<Vec2>& changedTiles) {
+  Rectangle tiles = layout->getAllTiles(getBounds(), objects.getBounds());
+  if (mem == lastMemory && lastTiles == tiles) {
+    for (Vec2 pos : changedTiles)
+      tileInfo[pos].connectionId = getFloorConnection(pos);
+    for (Vec2 pos : changedTiles) {
+      updateConnections(pos);
+      for (auto& dir : connectionDirs)
+        if ((pos + dir.first).inRectangle(tiles))
+          updateConnections(pos + dir.first);
+      updateShadow(pos);
+      updateShadow(pos + Vec2(0, 1));
+    }
+  } else {
+    if (lastTiles)
+      for (Vec2 pos : lastTiles->minusMargin(-1).intersection(tileInfo.getBounds()))
+        tileInfo[pos] = {0, 0, false};
+    lastMemory = mem;
+    lastTiles = tiles;
+    for (Vec2 pos : tiles)
+      tileInfo[pos].connectionId = getFloorConnection(pos);
+    for (Vec2 pos : tiles) {
+      updateConnections(pos);
+      updateShadow(pos);
+    }
+    for (int x : Range(tiles.getPX(), tiles.getKX()))
+      updateShadow(Vec2(x, tiles.getKY()));
+  }
 }
 
 const int bgTransparency = 180;
@@ -265,10 +326,12 @@ void MapGui::render(Renderer& renderer) {
     }
   }
   for (Vec2 wpos : layout->getAllTiles(getBounds(), levelBounds))
-    if (auto index = objects[wpos]) {
+    if (auto& index = objects[wpos]) {
       Vec2 pos = layout->projectOnScreen(getBounds(), wpos);
-      for (ViewIndex::HighlightInfo highlight : index->getHighlight())
-        renderer.drawFilledRectangle(pos.x, pos.y, pos.x + sizeX, pos.y + sizeY, getHighlightColor(highlight));
+      for (HighlightType highlight : highlightOrder)
+        if (index->hasHighlight(highlight))
+          renderer.drawFilledRectangle(pos.x, pos.y, pos.x + sizeX, pos.y + sizeY,
+              getHighlightColor(highlight, index->getHighlight(highlight)));
     }
   if (!hint.empty())
     drawHint(renderer, white, hint);
@@ -36,7 +36,8 @@ class MapGui : public GuiElem {
   virtual void onMouseRelease() override;
 
   void refreshObjects();
-  void updateObjects(const MapMemory*);
+  /** Updates cached information about the tiles in changedTiles, or all visible tiles if the view moved.*/
+  void updateObjects(const MapMemory*, const vector<Vec2>& changedTiles);
   void setLevelBounds(Rectangle bounds);
   void setLayout(MapLayout*);
   void setSpriteMode(bool);
@@ -50,9 +51,25 @@ class MapGui : public GuiElem {
   Optional<ViewObject> drawObjectAbs(Renderer& renderer, int x, int y, const ViewIndex& index, int sizeX, int sizeY,
       Vec2 tilePos, bool highlighted);
   void drawHint(Renderer& renderer, Color color, const string& text);
+  int getFloorConnection(Vec2 pos) const;
+  int getConnections(Vec2 pos, int connectionId) const;
+  void updateConnections(Vec2 pos);
+  void updateShadow(Vec2 pos);
+  bool castsShadow(Vec2 pos) const;
   MapLayout* layout;
   const Table<Optional<ViewIndex>>& objects;
   const MapMemory* lastMemory = nullptr;
+  Optional<Rectangle> lastTiles;
+  /** What a tile looks like depending on its neighbours. Only tiles inside lastTiles, or right below it
+    * in the case of shadows, have anything set.*/
+  struct TileInfo {
+    /** ConnectionId of the floor plus one, or zero if it doesn't connect to anything.*/
+    unsigned char connectionId;
+    /** Mask of the directions in which the floor connects, as in Tile::getSpriteCoord.*/
+    unsigned char connections;
+    bool shadowed;
+  };
+  Table<TileInfo> tileInfo;
   bool spriteMode;
   Rectangle levelBounds = Rectangle(1, 1);
   function<void(Vec2)> leftClickFun;
@@ -18,49 +18,182 @@
 #include "map_memory.h"
 #include "level.h"
 
-MapMemory::MapMemory() : table(Level::getMaxBounds()) {
+MapMemory::MapMemory() : MapMemory(Level::getMaxBounds()) {
 }
 
-MapMemory::MapMemory(const MapMemory& other) : table(other.table.getWidth(), other.table.getHeight()) {
-  for (Vec2 v : table.getBounds())
-    table[v] = other.table[v];
+MapMemory::MapMemory(Rectangle b) : bounds(b), chunksWidth((bounds.getW() + chunkSize - 1) / chunkSize),
+    chunks(chunksWidth * ((bounds.getH() + chunkSize - 1) / chunkSize)), pool(new Pool()) {
+}
+
+MapMemory::Chunk::Chunk() {
+  for (int i : Range(chunkSize * chunkSize)) {
+    index[i] = -1;
+    version[i] = 0;
+  }
 }
 
 template <class Archive> 
 void MapMemory::serialize(Archive& ar, const unsigned int version) {
-  ar & SVAR(table);
+  ar & SVAR(bounds);
+  // only chunks that contain anything are written
+  vector<int> chunkNums;
+  vector<int> chunkIndexes;
+  vector<ViewIndex> indexes;
+  vector<int> refCount;
+  if (Archive::is_saving::value) {
+    for (int i : All(chunks))
+      if (chunks[i]) {
+        chunkNums.push_back(i);
+        chunkIndexes.insert(chunkIndexes.end(), chunks[i]->index, chunks[i]->index + chunkSize * chunkSize);
+      }
+    indexes = pool->indexes;
+    refCount = pool->refCount;
+  }
+  ar & BOOST_SERIALIZATION_NVP(chunkNums)
+     & BOOST_SERIALIZATION_NVP(chunkIndexes)
+     & BOOST_SERIALIZATION_NVP(indexes)
+     & BOOST_SERIALIZATION_NVP(refCount);
+  if (Archive::is_loading::value) {
+    *this = MapMemory(bounds);
+    for (int i : All(chunkNums)) {
+      Chunk* chunk = new Chunk();
+      std::copy(chunkIndexes.begin() + i * chunkSize * chunkSize,
+          chunkIndexes.begin() + (i + 1) * chunkSize * chunkSize, chunk->index);
+      chunks[chunkNums[i]].reset(chunk);
+    }
+    for (int i : All(indexes))
+      if (refCount[i] > 0)
+        pool->ids.insert(make_pair(indexes[i], i));
+      else
+        pool->freeIds.push_back(i);
+    pool->indexes = std::move(indexes);
+    pool->refCount = std::move(refCount);
+  }
   CHECK_SERIAL;
 }
 
 SERIALIZABLE(MapMemory);
 
+MapMemory& MapMemory::getLevelMemory(map<Level*, MapMemory>& memory, Level* level) {
+  auto it = memory.find(level);
+  if (it == memory.end())
+    it = memory.insert(make_pair(level, MapMemory(level->getBounds()))).first;
+  return it->second;
+}
+
+int MapMemory::getChunkNum(Vec2 pos) const {
+  if (!pos.inRectangle(bounds))
+    return -1;
+  return (pos.y - bounds.getPY()) / chunkSize * chunksWidth + (pos.x - bounds.getPX()) / chunkSize;
+}
+
+int MapMemory::getTileNum(Vec2 pos) const {
+  return (pos.y - bounds.getPY()) % chunkSize * chunkSize + (pos.x - bounds.getPX()) % chunkSize;
+}
+
+MapMemory::Chunk& MapMemory::getChunkForWriting(Vec2 pos) {
+  int num = getChunkNum(pos);
+  CHECK(num > -1) << "Position " << pos << " out of memory bounds";
+  shared_ptr<Chunk>& chunk = chunks[num];
+  if (!chunk)
+    chunk.reset(new Chunk());
+  else if (chunk.use_count() > 1)
+    chunk.reset(new Chunk(*chunk));
+  return *chunk;
+}
+
+MapMemory::Pool& MapMemory::getPoolForWriting() {
+  if (pool.use_count() > 1)
+    pool.reset(new Pool(*pool));
+  return *pool;
+}
+
+static int versionCounter = 0;
+
+int MapMemory::getVersion(Vec2 pos) const {
+  int num = getChunkNum(pos);
+  if (num == -1 || !chunks[num])
+    return 0;
+  return chunks[num]->version[getTileNum(pos)];
+}
+
+void MapMemory::Pool::release(int id) {
+  if (id > -1 && --refCount[id] == 0) {
+    ids.erase(indexes[id]);
+    freeIds.push_back(id);
+  }
+}
+
+int MapMemory::Pool::add(const ViewIndex& index) {
+  int id;
+  auto it = ids.find(index);
+  if (it != ids.end())
+    id = it->second;
+  else {
+    if (!freeIds.empty()) {
+      id = freeIds.back();
+      freeIds.pop_back();
+      indexes[id] = index;
+      refCount[id] = 0;
+    } else {
+      id = indexes.size();
+      indexes.push_back(index);
+      refCount.push_back(0);
+    }
+    ids.insert(make_pair(index, id));
+  }
+  ++refCount[id];
+  return id;
+}
+
+void MapMemory::setViewIndex(Vec2 pos, const ViewIndex& index) {
+  Chunk& chunk = getChunkForWriting(pos);
+  Pool& pool = getPoolForWriting();
+  int& id = chunk.index[getTileNum(pos)];
+  int newId = pool.add(index);
+  pool.release(id);
+  id = newId;
+  chunk.version[getTileNum(pos)] = ++versionCounter;
+}
+
 void MapMemory::addObject(Vec2 pos, const ViewObject& obj) {
-  if (!table[pos])
-    table[pos] = ViewIndex();
-  table[pos]->insert(obj);
-  table[pos]->addHighlight(HighlightType::MEMORY);
+  ViewIndex index;
+  if (hasViewIndex(pos))
+    index = getViewIndex(pos);
+  index.insert(obj);
+  index.addHighlight(HighlightType::MEMORY);
+  setViewIndex(pos, index);
 }
 
 void MapMemory::update(Vec2 pos, const ViewIndex& index) {
-  table[pos] = ViewIndex();
-  table[pos]->addHighlight(HighlightType::MEMORY);
+  ViewIndex remembered;
+  remembered.addHighlight(HighlightType::MEMORY);
   for (ViewLayer l : { ViewLayer::ITEM, ViewLayer::FLOOR_BACKGROUND, ViewLayer::FLOOR, ViewLayer::LARGE_ITEM})
     if (index.hasObject(l))
-      addObject(pos, index.getObject(l));
-  for (auto highlight : index.getHighlight())
-    table[pos]->addHighlight(highlight);
+      remembered.insert(index.getObject(l));
+  for (HighlightType highlight : ENUM_ALL(HighlightType))
+    if (index.hasHighlight(highlight))
+      remembered.addHighlight(highlight, index.getHighlight(highlight));
+  setViewIndex(pos, remembered);
 }
 
 void MapMemory::clearSquare(Vec2 pos) {
-  table[pos] = Nothing();
+  if (!hasViewIndex(pos))
+    return;
+  Chunk& chunk = getChunkForWriting(pos);
+  getPoolForWriting().release(chunk.index[getTileNum(pos)]);
+  chunk.index[getTileNum(pos)] = -1;
+  chunk.version[getTileNum(pos)] = ++versionCounter;
 }
 
 bool MapMemory::hasViewIndex(Vec2 pos) const {
-  return table[pos];
+  int num = getChunkNum(pos);
+  return num > -1 && chunks[num] && chunks[num]->index[getTileNum(pos)] > -1;
 }
 
-ViewIndex MapMemory::getViewIndex(Vec2 pos) const {
-  return *table[pos];
+const ViewIndex& MapMemory::getViewIndex(Vec2 pos) const {
+  CHECK(hasViewIndex(pos));
+  return pool->indexes[chunks[getChunkNum(pos)]->index[getTileNum(pos)]];
 }
   
 const MapMemory& MapMemory::empty() {
@@ -20,24 +20,58 @@
 #include "view_index.h"
 #include "util.h"
 
+class Level;
+
+/** Remembered appearance of a level's tiles. Copies share storage until one of them is modified.*/
 class MapMemory {
   public:
   MapMemory();
-  MapMemory(const MapMemory&);
+  MapMemory(Rectangle bounds);
   void addObject(Vec2 pos, const ViewObject& obj);
   void update(Vec2, const ViewIndex&);
   void clearSquare(Vec2 pos);
   bool hasViewIndex(Vec2 pos) const;
-  ViewIndex getViewIndex(Vec2 pos) const;
+  const ViewIndex& getViewIndex(Vec2 pos) const;
+
+  /** Returns a stamp that changes whenever the remembered ViewIndex of the tile changes.*/
+  int getVersion(Vec2 pos) const;
+
   static const MapMemory& empty();
 
+  /** Returns the memory of the level, adding an empty one covering the level's bounds if needed.*/
+  static MapMemory& getLevelMemory(map<Level*, MapMemory>&, Level*);
+
   template <class Archive> 
   void serialize(Archive& ar, const unsigned int version);
 
   SERIAL_CHECKER;
 
   private:
-  Table<Optional<ViewIndex>> SERIAL(table);
+  void setViewIndex(Vec2 pos, const ViewIndex&);
+  static const int chunkSize = 16;
+  // Numbers of the remembered ViewIndex of a chunkSize x chunkSize block of tiles, or -1 if not remembered.
+  struct Chunk {
+    Chunk();
+    int index[chunkSize * chunkSize];
+    int version[chunkSize * chunkSize];
+  };
+  int getChunkNum(Vec2 pos) const;
+  int getTileNum(Vec2 pos) const;
+  Chunk& getChunkForWriting(Vec2 pos);
+  // Remembered tiles mostly look the same, so every distinct ViewIndex is stored once.
+  struct Pool {
+    void release(int id);
+    int add(const ViewIndex&);
+    vector<ViewIndex> indexes;
+    vector<int> refCount;
+    vector<int> freeIds;
+    unordered_map<ViewIndex, int> ids;
+  };
+  Pool& getPoolForWriting();
+  Rectangle SERIAL(bounds);
+  int chunksWidth;
+  vector<shared_ptr<Chunk>> chunks;
+  shared_ptr<Pool> pool;
 };
 
 #endif
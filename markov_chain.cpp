@@ -20,57 +20,98 @@
 #include "enums.h"
 #include "util.h"
 
-template <class T>
-template <class Archive>
-void MarkovChain<T>::serialize(Archive& ar, const unsigned int version) {
-  ar& SVAR(state)
-    & SVAR(transitions);
-  CHECK_SERIAL;
-}
-
-SERIALIZABLE(MarkovChain<MinionTask>);
-
 template<class T>
-MarkovChain<T>::MarkovChain(T s, map<T, vector<pair<T, double>>> t) : state(s), transitions(t) {
-  for (auto elem : transitions) {
+MarkovChain<T>::MarkovChain(T s, map<T, vector<pair<T, double>>> transitions) : initialState(s) {
+  for (auto& elem : transitions) {
+    int index = int(elem.first);
+    if (index >= rowIndex.size())
+      rowIndex.resize(index + 1, -1);
+    rowIndex[index] = next.size();
     double sum = 0;
     for (auto trans : elem.second) {
       sum += trans.second;
       CHECK(trans.first != elem.first);
+      CHECK(transitions.count(trans.first)) << "Transition to a state outside of the chain";
     }
     CHECK(sum <= 1.0000001);
+    nextOther.push_back(addDistribution(elem.second));
+    vector<pair<T, double>> all = elem.second;
     if (sum < 1)
-      transitions[elem.first].emplace_back(elem.first, 1 - sum);
+      all.emplace_back(elem.first, 1 - sum);
+    next.push_back(addDistribution(all));
+  }
+  CHECK(containsState(initialState));
+}
+
+// Vose's alias method: every slot holds its own outcome with probability threshold[i] and the alias
+// outcome otherwise.
+template<class T>
+typename MarkovChain<T>::Distribution MarkovChain<T>::addDistribution(const vector<pair<T, double>>& v) {
+  Distribution ret {int(outcomes.size()), int(v.size())};
+  double sum = 0;
+  for (auto& elem : v)
+    sum += elem.second;
+  vector<double> scaled;
+  vector<int> small, large;
+  for (int i : All(v)) {
+    outcomes.push_back(v[i].first);
+    threshold.push_back(1);
+    alias.push_back(ret.begin + i);
+    scaled.push_back(sum > 0 ? v[i].second * v.size() / sum : 1);
+    if (scaled.back() < 1)
+      small.push_back(i);
+    else
+      large.push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    int s = small.back();
+    small.pop_back();
+    int l = large.back();
+    threshold[ret.begin + s] = scaled[s];
+    alias[ret.begin + s] = ret.begin + l;
+    scaled[l] -= 1 - scaled[s];
+    if (scaled[l] < 1) {
+      large.pop_back();
+      small.push_back(l);
+    }
   }
+  // Whatever is left over has probability 1 up to rounding errors.
+  return ret;
 }
 
 template<class T>
-T MarkovChain<T>::getState() const {
-  return state;
+T MarkovChain<T>::sample(Distribution d) const {
+  double r = Random.getDouble() * d.size;
+  int i = min(d.size - 1, int(r));
+  if (r - i < threshold[d.begin + i])
+    return outcomes[d.begin + i];
+  else
+    return outcomes[alias[d.begin + i]];
 }
 
 template<class T>
-void MarkovChain<T>::setState(T s) {
-  state = s;
+T MarkovChain<T>::getInitialState() const {
+  return initialState;
 }
 
 template<class T>
-void MarkovChain<T>::update() {
-  state = chooseRandom(transitions.at(state));
+T MarkovChain<T>::getNext(T state) const {
+  CHECK(containsState(state));
+  return sample(next[rowIndex[int(state)]]);
 }
 
 template<class T>
-bool MarkovChain<T>::updateToNext() {
-  const vector<pair<T, double>> t = transitions.at(state);
-  if (t.size() == 1)
-    return false;
-  state = chooseRandom(getPrefix(t, 0, t.size() - 1));
-  return true;
+Optional<T> MarkovChain<T>::getNextOther(T state) const {
+  CHECK(containsState(state));
+  Distribution d = nextOther[rowIndex[int(state)]];
+  if (d.size == 0)
+    return Nothing();
+  return sample(d);
 }
 
 template<class T>
 bool MarkovChain<T>::containsState(T state) const {
-  return transitions.count(state);
+  return int(state) < rowIndex.size() && rowIndex[int(state)] > -1;
 }
 
 
@@ -16,23 +16,46 @@
 #ifndef _MARKOV_CHAIN
 #define _MARKOV_CHAIN
 
+#include "util.h"
 
+
+/**
+  * Immutable transition table of a Markov chain over an enum. Rows are kept in flat arrays and sampled
+  * in constant time using the alias method, so a single table can be shared by all users of a chain,
+  * who only need to remember their current state.
+  */
 template<class T>
 class MarkovChain {
   public:
+  /** Probability missing from a row is added as a transition back to the same state.*/
   MarkovChain(T initialState, map<T, vector<pair<T, double>>>);
 
-  T getState() const;
-  void setState(T);
-  void update();
-  bool updateToNext();
-  bool containsState(T) const;
+  T getInitialState() const;
+
+  /** Returns a random successor of the given state.*/
+  T getNext(T) const;
 
-  SERIALIZATION_DECL(MarkovChain);
+  /** Returns a random successor of the given state other than itself, or Nothing() if the
+      state only leads to itself.*/
+  Optional<T> getNextOther(T) const;
+
+  bool containsState(T) const;
 
   private:
-  T SERIAL(state);
-  map<T, vector<pair<T, double>>> SERIAL(transitions);
+  struct Distribution {
+    int begin;
+    int size;
+  };
+  Distribution addDistribution(const vector<pair<T, double>>&);
+  T sample(Distribution) const;
+
+  T initialState;
+  vector<T> outcomes;
+  vector<double> threshold;
+  vector<int> alias;
+  vector<Distribution> next;
+  vector<Distribution> nextOther;
+  vector<int> rowIndex;
 };
 
 #endif
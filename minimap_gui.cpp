@@ -24,6 +24,7 @@
 using namespace colors;
 
 static Image mapBuffer;
+static Texture mapTexture;
 static TextureRenderer renderer;
 
 void MinimapGui::render(Renderer& r) {
@@ -39,14 +40,48 @@ void MinimapGui::onLeftClick(Vec2 v) {
     clickFun();
 }
 
+void MinimapGui::clear() {
+  lastLevel = nullptr;
+  lastCreature = nullptr;
+}
+
 void MinimapGui::initialize() {
   mapBuffer.create(Level::getMaxBounds().getW(), Level::getMaxBounds().getH());
+  mapTexture.loadFromImage(mapBuffer);
   renderer.initialize(min(2048u, Texture::getMaximumSize()), min(2048u, Texture::getMaximumSize()));
 }
 
-static void putMapPixel(Vec2 pos, Color col) {
-  if (pos.inRectangle(Level::getMaxBounds()))
-    mapBuffer.setPixel(pos.x, pos.y, col);
+/** Uploads a part of mapBuffer to mapTexture.*/
+static void uploadPixels(Rectangle area) {
+  vector<sf::Uint8> pixels;
+  pixels.reserve(area.getW() * area.getH() * 4);
+  const sf::Uint8* buffer = mapBuffer.getPixelsPtr();
+  int width = mapBuffer.getSize().x;
+  for (int y : Range(area.getPY(), area.getKY()))
+    pixels.insert(pixels.end(), buffer + 4 * (y * width + area.getPX()), buffer + 4 * (y * width + area.getKX()));
+  mapTexture.update(pixels.data(), area.getW(), area.getH(), area.getPX(), area.getPY());
+}
+
+void MinimapGui::updateTiles(const Level* level, Rectangle levelPart, const CreatureView* creature) {
+  if (level != lastLevel || creature != lastCreature) {
+    tiles.reset(level->getBounds().intersection(Level::getMaxBounds()));
+    lastLevel = level;
+    lastCreature = creature;
+  }
+  if (!levelPart.intersects(tiles.getBounds()))
+    return;
+  for (Vec2 v : levelPart.intersection(tiles.getBounds())) {
+    const Square* square = level->getSquare(v);
+    bool known = creature->getMemory().hasViewIndex(v) || creature->canSee(v);
+    // the pixel only depends on the square's appearance, which changes along with its version
+    if (tiles.update(v, known ? square->getVersion() : MinimapTiles::unknown)) {
+      const ViewObject& object = square->getViewObject();
+      mapBuffer.setPixel(v.x, v.y, known ? Tile::getColor(object) : black);
+      tiles.setRoad(v, known && object.id() == ViewId::ROAD);
+    }
+  }
+  if (auto area = tiles.popDirtyArea())
+    uploadPixels(*area);
 }
 
 void MinimapGui::update(const Level* level, Rectangle levelPart, const CreatureView* creature, bool printLocations) {
@@ -55,26 +90,21 @@ void MinimapGui::update(const Level* level, Rectangle levelPart, const CreatureV
 
 void MinimapGui::update(const Level* level, Rectangle levelPart, Rectangle bounds, const CreatureView* creature,
     bool printLocations) {
-  vector<Vec2> roads;
+  updateTiles(level, levelPart, creature);
   double scale = min(double(bounds.getW()) / levelPart.getW(),
       double(bounds.getH()) / levelPart.getH());
-  for (Vec2 v : Rectangle(bounds.getW() / scale, bounds.getH() / scale)) {
-    putMapPixel(v, black);
-  }
-  for (Vec2 v : levelPart) {
-    if (!v.inRectangle(level->getBounds()) || (!creature->getMemory().hasViewIndex(v) && !creature->canSee(v)))
-      putMapPixel(v - levelPart.getTopLeft(), black);
-    else {
-      putMapPixel(v - levelPart.getTopLeft(), Tile::getColor(level->getSquare(v)->getViewObject()));
-      if (level->getSquare(v)->getName() == "road")
-        roads.push_back(v - levelPart.getTopLeft());
-    }
-  }
-  renderer.drawImage(bounds.getPX(), bounds.getPY(), bounds.getKX(), bounds.getKY(), mapBuffer, scale);
-  for (Vec2 v : roads) {
-    Vec2 rrad(1, 1);
-    Vec2 pos = bounds.getTopLeft() + v * scale;
-    renderer.drawFilledRectangle(Rectangle(pos - rrad, pos + rrad), brown);
+  renderer.drawFilledRectangle(bounds, black);
+  if (levelPart.intersects(tiles.getBounds())) {
+    Rectangle part = levelPart.intersection(tiles.getBounds());
+    Vec2 origin = bounds.getTopLeft() + (part.getTopLeft() - levelPart.getTopLeft()) * scale;
+    renderer.drawSprite(origin.x, origin.y, part.getPX(), part.getPY(), part.getW(), part.getH(), mapTexture,
+        part.getW() * scale, part.getH() * scale);
+    for (Vec2 v : part)
+      if (tiles.isRoad(v)) {
+        Vec2 rrad(1, 1);
+        Vec2 pos = bounds.getTopLeft() + (v - levelPart.getTopLeft()) * scale;
+        renderer.drawFilledRectangle(Rectangle(pos - rrad, pos + rrad), brown);
+      }
   }
   Vec2 playerPos = bounds.getTopLeft() + (creature->getPosition() - levelPart.getTopLeft()) * scale;
   Vec2 rad(3, 3);
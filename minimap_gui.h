@@ -19,6 +19,7 @@
 #include "util.h"
 #include "gui_elem.h"
 #include "texture_renderer.h"
+#include "minimap_tiles.h"
 
 class Level;
 class CreatureView;
@@ -38,11 +39,19 @@ class MinimapGui : public GuiElem {
   virtual void render(Renderer&) override;
   virtual void onLeftClick(Vec2) override;
 
+  /** Forgets the drawn pixels, so that the next update redraws them from scratch.*/
+  void clear();
+
   static void initialize();
 
   private:
+  void updateTiles(const Level* level, Rectangle levelPart, const CreatureView* creature);
+
   bool initialized = false;
   function<void()> clickFun;
+  MinimapTiles tiles;
+  const Level* lastLevel = nullptr;
+  const CreatureView* lastCreature = nullptr;
 };
 
 #endif
@@ -0,0 +1,55 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "minimap_tiles.h"
+
+void MinimapTiles::reset(Rectangle bounds) {
+  // a state that no tile has, so that every pixel is drawn once
+  tiles = Table<Tile>(bounds, {unknown - 1, false});
+  dirty = Nothing();
+}
+
+const Rectangle& MinimapTiles::getBounds() const {
+  return tiles.getBounds();
+}
+
+bool MinimapTiles::update(Vec2 pos, int state) {
+  Tile& tile = tiles[pos];
+  if (tile.state == state)
+    return false;
+  tile.state = state;
+  if (!dirty)
+    dirty = Rectangle(pos, pos + Vec2(1, 1));
+  else if (!pos.inRectangle(*dirty))
+    dirty = Rectangle(min(dirty->getPX(), pos.x), min(dirty->getPY(), pos.y),
+        max(dirty->getKX(), pos.x + 1), max(dirty->getKY(), pos.y + 1));
+  return true;
+}
+
+void MinimapTiles::setRoad(Vec2 pos, bool road) {
+  tiles[pos].road = road;
+}
+
+bool MinimapTiles::isRoad(Vec2 pos) const {
+  return tiles[pos].road;
+}
+
+Optional<Rectangle> MinimapTiles::popDirtyArea() {
+  Optional<Rectangle> ret = dirty;
+  dirty = Nothing();
+  return ret;
+}
@@ -0,0 +1,55 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _MINIMAP_TILES_H
+#define _MINIMAP_TILES_H
+
+#include "util.h"
+
+/**
+  * Remembers what every minimap pixel was last drawn from, so that only the pixels of tiles that changed
+  * have to be recomputed and uploaded to the texture.
+  */
+class MinimapTiles {
+  public:
+  /** Forgets all tiles and starts tracking the given area.*/
+  void reset(Rectangle bounds);
+
+  const Rectangle& getBounds() const;
+
+  /** The state of a tile that the viewer doesn't know about.*/
+  static const int unknown = -1;
+
+  /** Records the state that the tile's pixel is drawn from, e.g. the version of its square.
+    * Returns true if it differs from the last one, which means that the pixel has to be redrawn.*/
+  bool update(Vec2 pos, int state);
+
+  void setRoad(Vec2 pos, bool);
+  bool isRoad(Vec2 pos) const;
+
+  /** Returns the smallest rectangle containing all tiles that changed since the last call.*/
+  Optional<Rectangle> popDirtyArea();
+
+  private:
+  struct Tile {
+    int state;
+    bool road;
+  };
+  // replaced by reset() before use
+  Table<Tile> tiles = Table<Tile>(1, 1);
+  Optional<Rectangle> dirty;
+};
+
+#endif
@@ -89,11 +89,17 @@ const Creature* MinionEquipment::getOwner(const Item* it) const {
 }
 
 void MinionEquipment::discard(const Item* it) {
-  owners.erase(it->getUniqueId());
+  if (owners.erase(it->getUniqueId()))
+    ++numChanges;
 }
 
 void MinionEquipment::own(const Creature* c, const Item* it) {
   owners[it->getUniqueId()] = c;
+  ++numChanges;
+}
+
+int MinionEquipment::getNumChanges() const {
+  return numChanges;
 }
 
 bool MinionEquipment::isItemAppropriate(const Creature* c, const Item* it) const {
@@ -38,14 +38,20 @@ class MinionEquipment {
 
   int getItemValue(const Item*) const;
 
-  private:
   enum EquipmentType { ARMOR, HEALING, ARCHERY, COMBAT_ITEM };
+  const static int numEquipmentTypes = 4;
 
   static Optional<EquipmentType> getEquipmentType(const Item* it);
+
+  /** Incremented whenever an item changes its owner. Lets clients know when to refresh their caches.*/
+  int getNumChanges() const;
+
+  private:
   int getEquipmentLimit(EquipmentType type) const;
   bool isItemAppropriate(const Creature*, const Item*) const;
 
   map<UniqueId, const Creature*> SERIAL(owners);
+  int numChanges = 0;
 };
 
 #endif
@@ -47,6 +47,7 @@ void Model::serialize(Archive& ar, const unsigned int version) {
   Technology::serializeAll(ar);
   Vision::serializeAll(ar);
   Statistics::serialize(ar, version);
+  ar & boost::serialization::make_nvp("random", Random);
   updateSunlightInfo();
 }
 
@@ -178,9 +179,10 @@ void Model::tick(double time) {
   for (Creature* c : timeQueue.getAllCreatures()) {
     c->tick(time);
   }
-  for (PLevel& l : levels)
-    for (Square* square : l->getTickingSquares())
-      square->tick(time);
+  for (PLevel& l : levels) {
+    l->tick(time);
+    l->updateLight();
+  }
   lastTick = time;
   if (collective) {
     collective->tick();
@@ -213,6 +215,17 @@ Level* Model::buildLevel(Level::Builder&& b, LevelMaker* maker) {
   return levels.back().get();
 }
 
+vector<Level*> Model::buildLevels(WorldBuilder& builder) {
+  vector<Level*> ret;
+  for (PLevel& level : builder.build(this)) {
+    levels.push_back(std::move(level));
+    ret.push_back(levels.back().get());
+  }
+  for (const WorldBuilder::Link& link : builder.getLinks())
+    addLink(link.direction, link.key, ret[link.level1], ret[link.level2]);
+  return ret;
+}
+
 Model::Model(View* v) : view(v) {
   updateSunlightInfo();
 }
@@ -227,7 +240,7 @@ Level* Model::prepareTopLevel2(vector<SettlementInfo> settlements) {
   return top;
 }
 
-Level* Model::prepareTopLevel(vector<SettlementInfo> settlements) {
+int Model::prepareTopLevel(WorldBuilder& world, vector<SettlementInfo> settlements) {
   pair<CreatureFactory, string> castleNem1 = chooseRandom<pair<CreatureFactory, string>>(
       {{CreatureFactory::singleType(Tribe::get(TribeId::CASTLE_CELLAR), CreatureId::GHOST),
           "The castle cellar is haunted. Go and kill the evil that is lurking there."},
@@ -246,10 +259,10 @@ Level* Model::prepareTopLevel(vector<SettlementInfo> settlements) {
   Quest::set(QuestId::GOBLINS, Quest::killTribeQuest(Tribe::get(TribeId::GOBLIN),
         "The goblin den is located deep under the earth. "
       "Slay the great goblin. I will reward you.", true));
-  Level* top = buildLevel(
+  int top = world.addLevel(
       Level::Builder(500, 500, "Wilderness", false),
       LevelMaker::topLevel(CreatureFactory::forrest(), settlements));
-  Level* c1 = buildLevel(
+  int c1 = world.addLevel(
       Level::Builder(30, 20, "Crypt"),
       LevelMaker::cryptLevel(CreatureFactory::crypt(),{StairKey::CRYPT}, {}));
  /* Level* p1 = buildLevel(
@@ -258,19 +271,19 @@ Level* Model::prepareTopLevel(vector<SettlementInfo> settlements) {
   Level* p2 = buildLevel(
       Level::Builder(11, 11, "Pyramid Level 3"),
       LevelMaker::pyramidLevel(CreatureFactory::pyramid(2), {}, {StairKey::PYRAMID}));*/
-  Level* cellar = buildLevel(
+  int cellar = world.addLevel(
       Level::Builder(30, 20, "Cellar"),
       LevelMaker::cellarLevel(castleNem1.first,
           SquareType::LOW_ROCK_WALL, StairLook::CELLAR, {StairKey::CASTLE_CELLAR}, {}));
-  Level* dragon = buildLevel(
+  int dragon = world.addLevel(
       Level::Builder(40, 30, capitalFirst(castleNem2.second) + "'s Cave"),
       LevelMaker::cavernLevel(CreatureFactory::singleType(Tribe::get(TribeId::DRAGON), castleNem2.first),
           SquareType::MUD_WALL, SquareType::MUD, StairLook::NORMAL, {StairKey::DRAGON}, {}));
-  addLink(StairDirection::DOWN, StairKey::CRYPT, top, c1);
+  world.addLink(StairDirection::DOWN, StairKey::CRYPT, top, c1);
  // addLink(StairDirection::UP, StairKey::PYRAMID, top, p1);
  // addLink(StairDirection::UP, StairKey::PYRAMID, p1, p2);
-  addLink(StairDirection::DOWN, StairKey::CASTLE_CELLAR, top, cellar);
-  addLink(StairDirection::DOWN, StairKey::DRAGON, top, dragon); 
+  world.addLink(StairDirection::DOWN, StairKey::CASTLE_CELLAR, top, cellar);
+  world.addLink(StairDirection::DOWN, StairKey::DRAGON, top, dragon); 
 
   return top;
 }
@@ -290,7 +303,8 @@ Model* Model::heroModel(View* view) {
   Model* m = new Model(view);
   m->adventurer = true;
   Location* banditLocation = new Location("bandit hideout", "The bandits have robbed many travelers and townsfolk.");
-  Level* top = m->prepareTopLevel({
+  WorldBuilder world;
+  int top = m->prepareTopLevel(world, {
       {SettlementType::CASTLE, CreatureFactory::humanVillage(0.3), Random.getRandom(10, 20), CreatureId::AVATAR,
         getVillageLocation(), Tribe::get(TribeId::HUMAN), BuildingId::BRICK, {StairKey::CASTLE_CELLAR}, {},
           CreatureId::CASTLE_GUARD, Nothing(), ItemFactory::villageShop()},
@@ -306,24 +320,24 @@ Model* Model::heroModel(View* view) {
       Random.getRandom(4, 7), Nothing(), banditLocation, Tribe::get(TribeId::BANDIT), BuildingId::WOOD, {}, {}}
       });
   Quest::get(QuestId::BANDITS)->setLocation(banditLocation);
-  Level* d1 = m->buildLevel(
+  int d1 = world.addLevel(
       Level::Builder(60, 35, "Dwarven Halls"),
       LevelMaker::mineTownLevel({SettlementType::MINETOWN, CreatureFactory::dwarfTown(),
           Random.getRandom(10, 20), Nothing(), getVillageLocation(), Tribe::get(TribeId::DWARVEN),
           BuildingId::BRICK, {StairKey::DWARF}, {StairKey::DWARF}, Nothing(), Nothing(), ItemFactory::dwarfShop()}));
-  Level* g1 = m->buildLevel(
+  int g1 = world.addLevel(
       Level::Builder(60, 35, "Goblin Den"),
       LevelMaker::mineTownLevel({SettlementType::MINETOWN, CreatureFactory::goblinTown(1),
           Random.getRandom(10, 20), Nothing(), getVillageLocation(), Tribe::get(TribeId::GOBLIN),
           BuildingId::BRICK, {}, {StairKey::DWARF}, Nothing(), Nothing(), ItemFactory::goblinShop()}));
-  vector<Level*> gnomish;
+  vector<int> gnomish;
   int numGnomLevels = 8;
  // int towerLinkIndex = Random.getRandom(1, numGnomLevels - 1);
   for (int i = 0; i < numGnomLevels; ++i) {
     vector<StairKey> upKeys {StairKey::DWARF};
  /*   if (i == towerLinkIndex)
       upKeys.push_back(StairKey::TOWER);*/
-    gnomish.push_back(m->buildLevel(
+    gnomish.push_back(world.addLevel(
           Level::Builder(60, 35, "Gnomish Mines Level " + convertToString(i + 1)),
           LevelMaker::roomLevel(CreatureFactory::level(i + 1), upKeys, {StairKey::DWARF})));
   }
@@ -341,16 +355,17 @@ Model* Model::heroModel(View* view) {
  // m->addLink(StairDirection::DOWN, StairKey::TOWER, top, tower.back());
 
   for (int i = 0; i < numGnomLevels - 1; ++i)
-    m->addLink(StairDirection::DOWN, StairKey::DWARF, gnomish[i], gnomish[i + 1]);
+    world.addLink(StairDirection::DOWN, StairKey::DWARF, gnomish[i], gnomish[i + 1]);
 
-  m->addLink(StairDirection::DOWN, StairKey::DWARF, top, d1);
-  m->addLink(StairDirection::DOWN, StairKey::DWARF, d1, gnomish[0]);
-  m->addLink(StairDirection::UP, StairKey::DWARF, g1, gnomish.back());
+  world.addLink(StairDirection::DOWN, StairKey::DWARF, top, d1);
+  world.addLink(StairDirection::DOWN, StairKey::DWARF, d1, gnomish[0]);
+  world.addLink(StairDirection::UP, StairKey::DWARF, g1, gnomish.back());
+  vector<Level*> levels = m->buildLevels(world);
   PCreature player = m->makePlayer();
   for (int i : Range(Random.getRandom(70, 131)))
     player->take(ItemFactory::fromId(ItemId::GOLD_PIECE));
   Tribe::get(TribeId::GOBLIN)->makeSlightEnemy(player.get());
-  Level* start = top;
+  Level* start = levels[top];
   start->landCreature(StairDirection::UP, StairKey::PLAYER_SPAWN, std::move(player));
   setHandicap(Tribe::get(TribeId::PLAYER), Options::getValue(OptionId::EASY_ADVENTURER));
   return m;
@@ -25,6 +25,7 @@
 #include "village_control.h"
 #include "collective.h"
 #include "encyclopedia.h"
+#include "world_builder.h"
 
 class Collective;
 
@@ -93,13 +94,16 @@ class Model : public EventListener {
   Encyclopedia keeperopedia;
 
   private:
+  friend class KeeperStress;
+  friend class RenderBenchmark;
   void updateSunlightInfo();
   PCreature makePlayer();
   const Creature* getPlayer() const;
   void landHeroPlayer();
   Level* buildLevel(Level::Builder&& b, LevelMaker*);
+  vector<Level*> buildLevels(WorldBuilder&);
   void addLink(StairDirection, StairKey, Level*, Level*);
-  Level* prepareTopLevel(vector<SettlementInfo> settlements);
+  int prepareTopLevel(WorldBuilder&, vector<SettlementInfo> settlements);
   Level* prepareTopLevel2(vector<SettlementInfo> settlements);
 
   vector<PLevel> SERIAL(levels);
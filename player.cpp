@@ -63,7 +63,7 @@ void Player::onThrowEvent(const Creature* thrower, const Item* item, const vecto
 
 void Player::learnLocation(const Location* loc) {
   for (Vec2 v : loc->getBounds())
-    (*levelMemory)[creature->getLevel()].addObject(v, creature->getLevel()->getSquare(v)->getViewObject());
+    MapMemory::getLevelMemory(*levelMemory, creature->getLevel()).addObject(v, creature->getLevel()->getSquare(v)->getViewObject());
 }
 
 void Player::onExplosionEvent(const Level* level, Vec2 pos) {
@@ -528,7 +528,7 @@ void Player::spellAction() {
 }
 
 const MapMemory& Player::getMemory() const {
-  return (*levelMemory)[creature->getLevel()];
+  return MapMemory::getLevelMemory(*levelMemory, creature->getLevel());
 }
 
 void Player::sleeping() {
@@ -672,7 +672,7 @@ void Player::makeMove() {
     }
   }
   for (Vec2 pos : creature->getLevel()->getVisibleTiles(creature)) {
-    (*levelMemory)[creature->getLevel()].update(pos, creature->getLevel()->getSquare(pos)->getViewIndex(creature));
+    MapMemory::getLevelMemory(*levelMemory, creature->getLevel()).update(pos, creature->getLevel()->getSquare(pos)->getViewIndex(creature));
   }
 }
 
@@ -16,44 +16,102 @@
 #include "stdafx.h"
 
 #include "poison_gas.h"
-#include "level.h"
-
 
 template <class Archive> 
 void PoisonGas::serialize(Archive& ar, const unsigned int version) {
-  ar & SVAR(amount);
+  ar & SVAR(bounds)
+     & SVAR(active);
+  vector<float> activeAmount;
+  if (Archive::is_saving::value)
+    for (Vec2 v : active)
+      activeAmount.push_back(amount[v]);
+  ar & BOOST_SERIALIZATION_NVP(activeAmount);
+  if (Archive::is_loading::value) {
+    vector<Vec2> cells = std::move(active);
+    *this = PoisonGas(bounds);
+    for (int i : All(cells))
+      addAmount(cells[i], activeAmount[i]);
+  }
   CHECK_SERIAL;
 }
 
 SERIALIZABLE(PoisonGas);
 
-void PoisonGas::addAmount(double a) {
+PoisonGas::PoisonGas(Rectangle b) : bounds(b), amount(bounds, 0), next(bounds, 0), isActive(bounds, 0) {
+}
+
+void PoisonGas::activate(Vec2 pos) {
+  if (!isActive[pos]) {
+    isActive[pos] = 1;
+    active.push_back(pos);
+  }
+}
+
+void PoisonGas::addAmount(Vec2 pos, double a) {
   CHECK(a > 0);
-  amount = min(3., a + amount);
+  amount[pos] = min(3., a + amount[pos]);
+  activate(pos);
+}
+
+double PoisonGas::getAmount(Vec2 pos) const {
+  return amount[pos];
+}
+
+int PoisonGas::getNumActive() const {
+  return active.size();
 }
 
 const double decrease = 0.001;
 const double spread = 0.10;
+const double minAmount = 0.1;
 
-void PoisonGas::tick(Level* level, Vec2 pos) {
-  if (amount < 0.1) {
-    amount = 0;
-    return;
-  }
-  for (Vec2 v : Vec2::directions8(true)) {
-    Square* square = level->getSquare(pos + v);
-    if (square->canSeeThru() && amount > 0 && square->getPoisonGasAmount() < amount) {
-      double transfer = v.isCardinal4() ? spread : spread / 2;
-      transfer = min(amount, transfer);
-      transfer = min((amount - square->getPoisonGasAmount()) / 2, transfer);
-      amount -= transfer;
-      level->getSquare(v + pos)->addPoisonGas(transfer);
+static const Vec2 dirs8[] = {
+  Vec2(0, -1), Vec2(1, 0), Vec2(0, 1), Vec2(-1, 0), Vec2(1, -1), Vec2(1, 1), Vec2(-1, 1), Vec2(-1, -1)};
+
+const vector<Vec2>& PoisonGas::tick(function<bool(Vec2)> canSpread) {
+  // cells without gas are zero in both grids, so only the active ones need to be copied
+  for (Vec2 pos : active)
+    next[pos] = amount[pos];
+  int numActive = active.size();
+  for (int i = 0; i < numActive; ++i) {
+    Vec2 pos = active[i];
+    double current = amount[pos];
+    if (current < minAmount) {
+      next[pos] -= current;
+      continue;
+    }
+    // all transfers are computed from the amount at the start of the turn, so no direction is favored
+    double transfer[8];
+    double total = 0;
+    for (int j : Range(8)) {
+      Vec2 v = pos + dirs8[j];
+      transfer[j] = 0;
+      if (v.inRectangle(bounds) && amount[v] < current && canSpread(v)) {
+        transfer[j] = min((current - amount[v]) / 2, dirs8[j].isCardinal4() ? spread : spread / 2);
+        total += transfer[j];
+      }
     }
+    double scale = total > current ? current / total : 1;
+    for (int j : Range(8))
+      if (transfer[j] > 0) {
+        Vec2 v = pos + dirs8[j];
+        next[pos] -= transfer[j] * scale;
+        next[v] += transfer[j] * scale;
+        activate(v);
+      }
+    next[pos] = max(0.0f, next[pos] - float(decrease));
   }
-  amount = max(0.0, amount - decrease);
-}
-
-double PoisonGas::getAmount() const {
-  return amount;
+  changed = active;
+  for (Vec2 pos : changed)
+    amount[pos] = 0;
+  std::swap(amount, next);
+  active.clear();
+  for (Vec2 pos : changed)
+    if (amount[pos] > 0)
+      active.push_back(pos);
+    else {
+      amount[pos] = 0;
+      isActive[pos] = 0;
+    }
+  return changed;
 }
-
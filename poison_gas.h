@@ -18,22 +18,33 @@
 
 #include "util.h"
 
-class Level;
-
+/** The poison gas on a level. Amounts are kept in two dense grids, one read and one written on each tick,
+  * so the result doesn't depend on the order of the cells. Only cells with gas are visited, in the order
+  * in which the gas reached them, and a cell is retired once its gas is gone.*/
 class PoisonGas {
   public:
-  void addAmount(double amount);
-  void tick(Level*, Vec2 pos);
-  double getAmount() const;
+  PoisonGas(Rectangle bounds);
+
+  void addAmount(Vec2 pos, double amount);
+  double getAmount(Vec2 pos) const;
 
-  template <class Archive> 
-  void serialize(Archive& ar, const unsigned int version);
+  /** Spreads the gas to the neighboring cells accepted by the predicate and lets it dissipate.
+      Returns the cells whose amount has changed.*/
+  const vector<Vec2>& tick(function<bool(Vec2)> canSpread);
 
-  SERIAL_CHECKER;
+  /** Returns the number of cells that have any gas.*/
+  int getNumActive() const;
+
+  SERIALIZATION_DECL(PoisonGas);
 
   private:
-  double SERIAL2(amount, 0);
+  void activate(Vec2);
+  Rectangle SERIAL(bounds);
+  Table<float> amount;
+  Table<float> next;
+  Table<char> isActive;
+  vector<Vec2> SERIAL(active);
+  vector<Vec2> changed;
 };
 
 #endif
-
@@ -0,0 +1,55 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "random_benchmark.h"
+
+RandomBenchmark::RandomBenchmark(int n) : numDraws(n) {
+  CHECK(numDraws > 0);
+}
+
+template <class Fun>
+static double measureNanos(int numDraws, Fun fun) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < numDraws; ++i)
+    fun();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / numDraws;
+}
+
+void RandomBenchmark::run() {
+  results.clear();
+  default_random_engine engine(1);
+  uniform_real_distribution<double> dist;
+  results.push_back({"default_random_engine",
+      measureNanos(numDraws, [&] { checksum += uniform_int_distribution<int>(0, 99)(engine); }),
+      measureNanos(numDraws, [&] { checksum += dist(engine); }),
+      // The closest thing to a split is seeding a new engine from the old one.
+      measureNanos(numDraws, [&] { checksum += default_random_engine(engine())(); })});
+  RandomGen gen;
+  gen.init(1);
+  results.push_back({"RandomGen",
+      measureNanos(numDraws, [&] { checksum += gen.getRandom(0, 100); }),
+      measureNanos(numDraws, [&] { checksum += gen.getDouble(); }),
+      measureNanos(numDraws, [&] { checksum += gen.split().getRandom(0, 100); })});
+}
+
+void RandomBenchmark::printResults(std::ostream& out) const {
+  out << "engine,draws,int ns,double ns,split ns" << endl;
+  for (const Result& result : results)
+    out << result.engine << "," << numDraws << "," << result.intNanos << "," << result.doubleNanos << ","
+        << result.splitNanos << endl;
+  Debug() << "Random benchmark checksum " << checksum;
+}
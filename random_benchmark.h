@@ -0,0 +1,47 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _RANDOM_BENCHMARK_H
+#define _RANDOM_BENCHMARK_H
+
+#include "util.h"
+
+/**
+  * Measures how fast RandomGen draws numbers and splits streams, compared to the standard
+  * library engine it replaced.
+  */
+class RandomBenchmark {
+  public:
+  RandomBenchmark(int numDraws);
+
+  void run();
+
+  /** Prints the time per draw of each engine in nanoseconds as CSV.*/
+  void printResults(std::ostream&) const;
+
+  private:
+  struct Result {
+    string engine;
+    double intNanos;
+    double doubleNanos;
+    double splitNanos;
+  };
+  int numDraws;
+  vector<Result> results;
+  // Sum of everything drawn, so that the compiler can't skip the draws.
+  double checksum = 0;
+};
+
+#endif
@@ -0,0 +1,64 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "render_benchmark.h"
+#include "window_view.h"
+#include "model.h"
+#include "enums.h"
+
+RenderBenchmark::RenderBenchmark(int n) : numFrames(n) {
+  CHECK(numFrames > 0);
+}
+
+void RenderBenchmark::run(WindowView& view, Model& model) {
+  CHECK(model.collective) << "Not a keeper game";
+  view.setWindowVisible(false);
+  for (bool zoomedOut : {false, true}) {
+    view.reset();
+    view.zoom(zoomedOut);
+    view.frameStats.clear();
+    int numRebuilt = 0;
+    int numReused = 0;
+    int numGuiElems = 0;
+    for (int i : Range(numFrames)) {
+      view.refreshView(model.collective.get());
+      numRebuilt += view.getRefreshStats().numRebuilt;
+      numReused += view.getRefreshStats().numReused;
+      // The first frame builds the whole GUI, after that only changed panels are rebuilt.
+      if (i > 0)
+        numGuiElems += view.getRefreshStats().numGuiElems;
+    }
+    results.push_back({zoomedOut ? "out" : "normal", view.getFrameStats(), numRebuilt, numReused,
+        numGuiElems});
+  }
+  view.setWindowVisible(true);
+}
+
+void RenderBenchmark::printResults(std::ostream& out) const {
+  out << "zoom,frames,tiles_rebuilt,tiles_reused,gui_elems_after_first,percentile";
+  for (FramePhase phase : ENUM_ALL(FramePhase))
+    out << "," << FrameStats::getName(phase);
+  out << ",total" << std::endl;
+  for (const Result& result : results)
+    for (double fraction : {0.5, 0.9, 0.99, 1.0}) {
+      out << result.zoom << "," << result.stats.getNumFrames() << "," << result.numRebuilt << ","
+          << result.numReused << "," << result.numGuiElems << "," << int(fraction * 100);
+      for (FramePhase phase : ENUM_ALL(FramePhase))
+        out << "," << result.stats.getPercentile(phase, fraction);
+      out << "," << result.stats.getTotalPercentile(fraction) << std::endl;
+    }
+}
@@ -0,0 +1,51 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _RENDER_BENCHMARK_H
+#define _RENDER_BENCHMARK_H
+
+#include "util.h"
+#include "frame_stats.h"
+
+class WindowView;
+class Model;
+
+/**
+  * Renders the map of a keeper game in a hidden window a number of times at each zoom level,
+  * measuring how long the phases of a frame take.
+  */
+class RenderBenchmark {
+  public:
+  RenderBenchmark(int numFrames);
+
+  /** Draws the model's collective in the view, which has to be initialized.*/
+  void run(WindowView&, Model&);
+
+  /** Prints the percentiles of every phase for each zoom level as CSV.*/
+  void printResults(std::ostream&) const;
+
+  private:
+  struct Result {
+    string zoom;
+    FrameStats stats;
+    int numRebuilt;
+    int numReused;
+    int numGuiElems;
+  };
+  int numFrames;
+  vector<Result> results;
+};
+
+#endif
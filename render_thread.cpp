@@ -0,0 +1,80 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "render_thread.h"
+
+RenderThread::RenderThread() {
+}
+
+RenderThread::~RenderThread() {
+  {
+    std::unique_lock<std::mutex> lock(mut);
+    stopped = true;
+  }
+  cond.notify_all();
+  if (worker.joinable())
+    worker.join();
+}
+
+void RenderThread::draw(function<void()> f) {
+  wait();
+  std::unique_lock<std::mutex> lock(mut);
+  // the thread is started lazily so that views that never draw in the background don't own one
+  if (!worker.joinable())
+    worker = thread([this] { loop(); });
+  frame = f;
+  busy = true;
+  cond.notify_all();
+}
+
+void RenderThread::wait() {
+  std::unique_lock<std::mutex> lock(mut);
+  cond.wait(lock, [this] { return !busy; });
+  if (exception) {
+    std::exception_ptr e = exception;
+    exception = nullptr;
+    std::rethrow_exception(e);
+  }
+}
+
+bool RenderThread::isBusy() {
+  std::unique_lock<std::mutex> lock(mut);
+  return busy;
+}
+
+void RenderThread::loop() {
+  while (1) {
+    function<void()> f;
+    {
+      std::unique_lock<std::mutex> lock(mut);
+      cond.wait(lock, [this] { return busy || stopped; });
+      if (!busy)
+        return;
+      f = frame;
+    }
+    try {
+      f();
+    } catch (...) {
+      std::unique_lock<std::mutex> lock(mut);
+      exception = std::current_exception();
+    }
+    std::unique_lock<std::mutex> lock(mut);
+    frame = nullptr;
+    busy = false;
+    cond.notify_all();
+  }
+}
@@ -0,0 +1,52 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _RENDER_THREAD_H
+#define _RENDER_THREAD_H
+
+#include "util.h"
+
+/**
+  * Runs frames on a separate thread, one at a time. The caller prepares everything a frame needs before
+  * handing it over, and must call wait() before touching that state again, so the frame always sees
+  * a consistent snapshot while the caller carries on with other work.
+  */
+class RenderThread {
+  public:
+  RenderThread();
+  ~RenderThread();
+
+  /** Waits until the previous frame is finished and schedules the given one.*/
+  void draw(function<void()> frame);
+
+  /** Blocks until the scheduled frame, if any, is finished. Rethrows anything that the frame has thrown.*/
+  void wait();
+
+  /** Returns true if a frame is scheduled or being drawn.*/
+  bool isBusy();
+
+  private:
+  void loop();
+
+  std::mutex mut;
+  std::condition_variable cond;
+  function<void()> frame;
+  bool busy = false;
+  bool stopped = false;
+  std::exception_ptr exception;
+  thread worker;
+};
+
+#endif
@@ -57,15 +57,13 @@ namespace colors {
   }
 }
 
+Renderer::Renderer() : spriteBatch(this) {
+}
+
 vector<Texture> Renderer::tiles;
 const vector<int> Renderer::tileSize { 36, 36, 36, 24, 36, 36 };
 const int Renderer::nominalSize = 36;
 
-int Renderer::getTextLength(string s) {
-  Text t(s, textFont, textSize);
-  return t.getLocalBounds().width;
-}
-
 Font& getFont(Renderer::FontId id) {
   switch (id) {
     case Renderer::TEXT_FONT: return textFont;
@@ -76,28 +74,118 @@ Font& getFont(Renderer::FontId id) {
   return textFont;
 }
 
-void Renderer::drawText(FontId id, int size, Color color, int x, int y, String s, bool center) {
+/** Texture ids passed to the sprite batch below this number are tiles, the others are font pages.*/
+static const int firstFontTexture = 64;
+
+/** Above this many strings the text layout cache is cleared.*/
+static const int maxTextLayouts = 5000;
+
+bool Renderer::TextKey::operator == (const TextKey& o) const {
+  return font == o.font && size == o.size && text == o.text;
+}
+
+size_t Renderer::TextKeyHash::operator()(const TextKey& key) const {
+  return hash<string>()(key.text) * 31 + key.size * 3 + key.font;
+}
+
+int Renderer::getFontTexture(FontId id, int size) {
+  auto key = make_pair(id, size);
+  if (!fontTextureIds.count(key)) {
+    // rasterize the printable ASCII characters up front, so that the glyph atlas rarely changes later
+    for (sf::Uint32 c = 32; c < 127; ++c)
+      getFont(id).getGlyph(c, size, false);
+    fontTextureIds[key] = firstFontTexture + fontTextures.size();
+    fontTextures.push_back(&getFont(id).getTexture(size));
+  }
+  return fontTextureIds.at(key);
+}
+
+Renderer::TextLayout Renderer::makeTextLayout(FontId id, int size, const string& utf8) {
+  Font& font = getFont(id);
+  TextLayout ret {getFontTexture(id, size), {}, 0, 0};
+  if (utf8.empty())
+    return ret;
+  // same placement as sf::Text
+  float hspace = font.getGlyph(L' ', size, false).advance;
+  float vspace = font.getLineSpacing(size);
+  float x = 0;
+  float y = size;
+  float minX = size;
+  float maxX = 0;
+  sf::Uint32 prevChar = 0;
+  for (auto it = utf8.begin(); it != utf8.end();) {
+    sf::Uint32 curChar;
+    it = sf::Utf8::decode(it, utf8.end(), curChar);
+    x += font.getKerning(prevChar, curChar, size);
+    prevChar = curChar;
+    if (curChar == ' ' || curChar == '\t' || curChar == '\n') {
+      minX = min(minX, x);
+      switch (curChar) {
+        case ' ': x += hspace; break;
+        case '\t': x += hspace * 4; break;
+        case '\n': y += vspace; x = 0; break;
+      }
+      maxX = max(maxX, x);
+      continue;
+    }
+    const sf::Glyph& glyph = font.getGlyph(curChar, size, false);
+    float left = glyph.bounds.left;
+    float top = glyph.bounds.top;
+    ret.quads.push_back({x + left, y + top, float(glyph.bounds.width), float(glyph.bounds.height),
+        float(glyph.textureRect.left), float(glyph.textureRect.top), float(glyph.textureRect.width),
+        float(glyph.textureRect.height), 255, 255, 255, 255});
+    minX = min(minX, x + left);
+    maxX = max(maxX, x + left + glyph.bounds.width);
+    x += glyph.advance;
+  }
+  ret.left = minX;
+  ret.width = maxX - minX;
+  return ret;
+}
+
+const Renderer::TextLayout& Renderer::getTextLayout(FontId id, int size, const string& utf8) {
+  textKey.font = id;
+  textKey.size = size;
+  textKey.text.assign(utf8);
+  auto it = textLayouts.find(textKey);
+  if (it != textLayouts.end())
+    return it->second;
+  if (textLayouts.size() >= maxTextLayouts)
+    textLayouts.clear();
+  return textLayouts.insert(make_pair(textKey, makeTextLayout(id, size, utf8))).first->second;
+}
+
+int Renderer::getTextLength(const string& s) {
+  return getTextLayout(TEXT_FONT, textSize, s).width;
+}
+
+void Renderer::drawTextLayout(const TextLayout& layout, Color color, int x, int y, bool center) {
   int ox = 0;
-  int oy = 0;
-  Text t(s, getFont(id), size);
-  if (center) {
-    sf::FloatRect bounds = t.getLocalBounds();
-    ox -= bounds.left + bounds.width / 2;
-    //oy -= bounds.top + bounds.height / 2;
+  if (center)
+    ox -= layout.left + layout.width / 2;
+  for (SpriteBatch::Quad quad : layout.quads) {
+    quad.x += x + ox;
+    quad.y += y;
+    quad.r = color.r;
+    quad.g = color.g;
+    quad.b = color.b;
+    quad.a = color.a;
+    spriteBatch.add(layout.texture, quad);
   }
-  t.setPosition(x + ox, y + oy);
-  t.setColor(color);
-  display->draw(t);
 }
 
-void Renderer::drawText(Color color, int x, int y, string s, bool center, int size) {
-  std::basic_string<sf::Uint32> utf32;
-  sf::Utf8::toUtf32(s.begin(), s.end(), std::back_inserter(utf32));
-  drawText(TEXT_FONT, size, color, x, y, utf32, center);
+void Renderer::drawText(FontId id, int size, Color color, int x, int y, const String& s, bool center) {
+  utf8Buffer.clear();
+  sf::Utf32::toUtf8(s.begin(), s.end(), std::back_inserter(utf8Buffer));
+  drawTextLayout(getTextLayout(id, size, utf8Buffer), color, x, y, center);
+}
+
+void Renderer::drawText(Color color, int x, int y, const string& s, bool center, int size) {
+  drawTextLayout(getTextLayout(TEXT_FONT, size, s), color, x, y, center);
 }
 
 void Renderer::drawText(Color color, int x, int y, const char* c, bool center, int size) {
-  drawText(TEXT_FONT, size, color, x, y, String(c), center);
+  drawTextLayout(getTextLayout(TEXT_FONT, size, c), color, x, y, center);
 }
 
 void Renderer::drawTextWithHotkey(Color color, int x, int y, const string& text, char key) {
@@ -116,6 +204,7 @@ void Renderer::drawImage(int px, int py, const Image& image, double scale) {
 }
 
 void Renderer::drawImage(int px, int py, int kx, int ky, const Image& image, double scale) {
+  flush();
   Texture t;
   t.loadFromImage(image);
   Sprite s(t, sf::IntRect(0, 0, (kx - px) / scale, (ky - py) / scale));
@@ -131,6 +220,13 @@ void Renderer::drawSprite(Vec2 pos, Vec2 spos, Vec2 size, const Texture& t, Opti
 
 void Renderer::drawSprite(int x, int y, int px, int py, int w, int h, const Texture& t, int dw, int dh,
     Optional<Color> color) {
+  if (&t >= tiles.data() && &t < tiles.data() + tiles.size()) {
+    Color c = color ? *color : Color::White;
+    spriteBatch.add(&t - tiles.data(), {float(x), float(y), float(dw == -1 ? w : dw), float(dh == -1 ? h : dh),
+        float(px), float(py), float(w), float(h), c.r, c.g, c.b, c.a});
+    return;
+  }
+  flush();
   Sprite s(t, sf::IntRect(px, py, w, h));
   s.setPosition(x, y);
   if (color)
@@ -141,6 +237,7 @@ void Renderer::drawSprite(int x, int y, int px, int py, int w, int h, const Text
 }
 
 void Renderer::drawFilledRectangle(const Rectangle& t, Color color, Optional<Color> outline) {
+  flush();
   RectangleShape r(Vector2f(t.getW(), t.getH()));
   r.setPosition(t.getPX(), t.getPY());
   r.setFillColor(color);
@@ -163,8 +260,27 @@ int Renderer::getHeight() {
   return display->getSize().y;
 }
 
+void Renderer::flush() {
+  spriteBatch.flush();
+  spriteBatch.setScreenSize(getWidth(), getHeight());
+}
+
+void Renderer::drawQuads(int texture, const vector<SpriteBatch::Quad>& quads) {
+  vertices.clear();
+  for (const SpriteBatch::Quad& q : quads) {
+    Color color(q.r, q.g, q.b, q.a);
+    vertices.emplace_back(Vector2f(q.x, q.y), color, Vector2f(q.texX, q.texY));
+    vertices.emplace_back(Vector2f(q.x + q.w, q.y), color, Vector2f(q.texX + q.texW, q.texY));
+    vertices.emplace_back(Vector2f(q.x + q.w, q.y + q.h), color, Vector2f(q.texX + q.texW, q.texY + q.texH));
+    vertices.emplace_back(Vector2f(q.x, q.y + q.h), color, Vector2f(q.texX, q.texY + q.texH));
+  }
+  const Texture* tex = texture < firstFontTexture ? &tiles[texture] : fontTextures[texture - firstFontTexture];
+  display->draw(vertices.data(), vertices.size(), sf::Quads, RenderStates(tex));
+}
+
 void Renderer::initialize(RenderTarget* d, int width, int height) {
   display = d;
+  spriteBatch.setScreenSize(getWidth(), getHeight());
   CHECK(textFont.loadFromFile("Lato-Bol.ttf"));
   CHECK(tileFont.loadFromFile("Lato-Bol.ttf"));
   CHECK(symbolFont.loadFromFile("Symbola.ttf"));
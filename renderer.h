@@ -19,6 +19,7 @@
 #include <SFML/Graphics.hpp>
 
 #include "util.h"
+#include "sprite_batch.h"
 
 using sf::Font;
 using sf::Color;
@@ -72,15 +73,16 @@ enum class SpriteId {
   HELP,
 };
 
-class Renderer {
+class Renderer : public SpriteBatch::Backend {
   public: 
+  Renderer();
   const static int textSize = 19;
   enum FontId { TEXT_FONT, TILE_FONT, SYMBOL_FONT };
   void initialize(RenderTarget*, int width, int height);
-  int getTextLength(string s);
-  void drawText(FontId, int size, Color color, int x, int y, String s, bool center = false);
+  int getTextLength(const string& s);
+  void drawText(FontId, int size, Color color, int x, int y, const String& s, bool center = false);
   void drawTextWithHotkey(Color color, int x, int y, const string& text, char key);
-  void drawText(Color color, int x, int y, string s, bool center = false, int size = textSize);
+  void drawText(Color color, int x, int y, const string& s, bool center = false, int size = textSize);
   void drawText(Color color, int x, int y, const char* c, bool center = false, int size = textSize);
   void drawImage(int px, int py, const Image& image, double scale = 1);
   void drawImage(int px, int py, int kx, int ky, const Image& image, double scale = 1);
@@ -93,12 +95,46 @@ class Renderer {
   int getWidth();
   int getHeight();
 
+  /** Sprites using one of the tiles textures and text glyphs are queued and drawn in batches.
+      This draws everything that has been queued so far.*/
+  void flush();
+  virtual void drawQuads(int texture, const vector<SpriteBatch::Quad>&) override;
+
   static vector<Texture> tiles;
   const static vector<int> tileSize;
   const static int nominalSize;
 
   private:
+  /** Glyph quads of a string placed at (0, 0), and its horizontal bounds.*/
+  struct TextLayout {
+    int texture;
+    vector<SpriteBatch::Quad> quads;
+    float left;
+    float width;
+  };
+  struct TextKey {
+    bool operator == (const TextKey&) const;
+    FontId font;
+    int size;
+    string text;
+  };
+  struct TextKeyHash {
+    size_t operator()(const TextKey&) const;
+  };
+  const TextLayout& getTextLayout(FontId, int size, const string& utf8);
+  TextLayout makeTextLayout(FontId, int size, const string& utf8);
+  int getFontTexture(FontId, int size);
+  void drawTextLayout(const TextLayout&, Color color, int x, int y, bool center);
+
   RenderTarget* display = nullptr;
+  SpriteBatch spriteBatch;
+  vector<sf::Vertex> vertices;
+  unordered_map<TextKey, TextLayout, TextKeyHash> textLayouts;
+  /** Reused for lookups in textLayouts, so that they don't allocate.*/
+  TextKey textKey;
+  string utf8Buffer;
+  map<pair<FontId, int>, int> fontTextureIds;
+  vector<const Texture*> fontTextures;
 };
 
 #endif
@@ -19,85 +19,207 @@
 template <class Archive> 
 void Sectors::serialize(Archive& ar, const unsigned int version) {
   ar& SVAR(bounds)
-    & SVAR(sectors)
+    & SVAR(nodes)
+    & SVAR(parent)
     & SVAR(sizes);
   CHECK_SERIAL;
 }
 
 SERIALIZABLE(Sectors);
 
-Sectors::Sectors(Rectangle b) : bounds(b), sectors(bounds, -1) {
+static const Vec2 dirs8[] = {
+  Vec2(-1, -1), Vec2(0, -1), Vec2(1, -1), Vec2(1, 0), Vec2(1, 1), Vec2(0, 1), Vec2(-1, 1), Vec2(-1, 0)};
+
+Sectors::Sectors(Rectangle b) : bounds(b), nodes(bounds, -1) {
 }
 
 bool Sectors::same(Vec2 v, Vec2 w) const {
-  return sectors[v] > -1 && sectors[v] == sectors[w];
+  return nodes[v] > -1 && nodes[w] > -1 && find(nodes[v]) == find(nodes[w]);
 }
 
-void Sectors::add(Vec2 pos) {
-  if (sectors[pos] > -1)
-    return;
-  set<int> neighbors;
-  for (Vec2 v : pos.neighbors8())
-    if (v.inRectangle(bounds) && sectors[v] > -1)
-      neighbors.insert(sectors[v]);
-  if (neighbors.size() == 0)
-    setSector(pos, getNewSector());
-  else
-  if (neighbors.size() == 1)
-    setSector(pos, *neighbors.begin());
-  else {
-    int largest = -1;
-    for (int elem : neighbors)
-      if (largest == -1 || sizes[largest] < sizes[elem])
-        largest = elem;
-    join(pos, largest);
+int Sectors::newNode() {
+  parent.push_back(parent.size());
+  sizes.push_back(1);
+  return parent.size() - 1;
+}
+
+int Sectors::find(int node) const {
+  int root = node;
+  while (parent[root] != root)
+    root = parent[root];
+  while (parent[node] != root) {
+    int next = parent[node];
+    parent[node] = root;
+    node = next;
   }
-  Debug() << "Sectors " << vector<int>(neighbors.begin(), neighbors.end())
-    << " joined " << sectors[pos] << " size " << sizes[sectors[pos]];
+  return root;
 }
 
-void Sectors::setSector(Vec2 pos, int sector) {
-  CHECK(sectors[pos] != sector);
-  if (sectors[pos] > -1)
-    --sizes[sectors[pos]];
-  sectors[pos] = sector;
-  ++sizes[sector];
+void Sectors::join(int node1, int node2) {
+  int root1 = find(node1);
+  int root2 = find(node2);
+  if (root1 == root2)
+    return;
+  if (sizes[root1] < sizes[root2])
+    std::swap(root1, root2);
+  parent[root2] = root1;
+  sizes[root1] += sizes[root2];
 }
 
-int Sectors::getNewSector() {
-  sizes.push_back(0);
-  return sizes.size() - 1;
+void Sectors::add(Vec2 pos) {
+  if (nodes[pos] > -1)
+    return;
+  // nodes of removed squares are left behind in the forest, so every now and then it's rebuilt from scratch
+  if (parent.size() >= 2 * bounds.getW() * bounds.getH())
+    compact();
+  nodes[pos] = newNode();
+  for (Vec2 dir : dirs8) {
+    Vec2 v = pos + dir;
+    if (v.inRectangle(bounds) && nodes[v] > -1)
+      join(nodes[pos], nodes[v]);
+  }
 }
 
-void Sectors::join(Vec2 pos1, int sector) {
-  queue<Vec2> q;
-  q.push(pos1);
-  setSector(pos1, sector);
-  while (!q.empty()) {
-    Vec2 pos = q.front();
-    q.pop();
-    for (Vec2 v : pos.neighbors8())
-      if (v.inRectangle(bounds) && sectors[v] > -1 && sectors[v] != sector) {
-        setSector(v, sector);
-        q.push(v);
-      }
+vector<Vec2> Sectors::getNeighborGroups(Vec2 pos) const {
+  int group[8];
+  for (int i : Range(8)) {
+    Vec2 v = pos + dirs8[i];
+    group[i] = (v.inRectangle(bounds) && nodes[v] > -1) ? i : -1;
   }
+  for (int i : Range(8))
+    for (int j : Range(i + 1, 8))
+      if (group[i] > -1 && group[j] > -1 && group[i] != group[j]
+          && (dirs8[i] - dirs8[j]).length8() == 1) {
+        int merged = group[j];
+        for (int k : Range(8))
+          if (group[k] == merged)
+            group[k] = group[i];
+      }
+  vector<Vec2> ret;
+  for (int i : Range(8))
+    if (group[i] == i)
+      ret.push_back(pos + dirs8[i]);
+  return ret;
 }
 
 void Sectors::remove(Vec2 pos) {
-  if (sectors[pos] == -1)
+  if (nodes[pos] == -1)
     return;
-  int curNumber = sizes[sectors[pos]];
-  --sizes[sectors[pos]];
-  sectors[pos] = -1;
-  int maxSector = sizes.size() - 1;
+  int root = find(nodes[pos]);
+  --sizes[root];
+  nodes[pos] = -1;
+  vector<Vec2> groups = getNeighborGroups(pos);
+  // if the neighbors are connected around the square then removing it can't split the sector
+  if (groups.size() > 1)
+    split(pos, root, groups);
+}
+
+void Sectors::split(Vec2 pos, int root, const vector<Vec2>& groups) {
+  // Run a breadth-first search from each group in turns. Searches that meet are merged. When at most one
+  // is still running, the finished ones have explored whole, separate sectors, which are then relabeled.
+  int oldSize = sizes[root] + 1;
+  int numSearches = groups.size();
+  vector<queue<Vec2>> queues(numSearches);
+  vector<int> owner(numSearches);
+  unordered_map<Vec2, int> visited;
+  for (int i : Range(numSearches)) {
+    owner[i] = i;
+    queues[i].push(groups[i]);
+    visited[groups[i]] = i;
+  }
+  auto getOwner = [&] (int search) {
+    while (owner[search] != search)
+      search = owner[search];
+    return search;
+  };
+  vector<bool> running(numSearches);
+  while (1) {
+    int numRunning = 0;
+    int numOwners = 0;
+    for (int i : Range(numSearches)) {
+      running[i] = false;
+      numOwners += (getOwner(i) == i);
+    }
+    for (int i : Range(numSearches))
+      if (!queues[i].empty() && !running[getOwner(i)]) {
+        running[getOwner(i)] = true;
+        ++numRunning;
+      }
+    if (numOwners == 1)
+      return;
+    if (numRunning <= 1)
+      break;
+    for (int i : Range(numSearches))
+      if (!queues[i].empty()) {
+        Vec2 cur = queues[i].front();
+        queues[i].pop();
+        for (Vec2 dir : dirs8) {
+          Vec2 v = cur + dir;
+          if (!v.inRectangle(bounds) || nodes[v] == -1)
+            continue;
+          auto it = visited.find(v);
+          if (it == visited.end()) {
+            visited[v] = i;
+            queues[i].push(v);
+          } else if (getOwner(it->second) != getOwner(i))
+            owner[getOwner(it->second)] = getOwner(i);
+        }
+      }
+  }
+  // the sector that is still being explored keeps its labels. If all searches finished, the last one does.
+  int keep = -1;
+  for (int i : Range(numSearches))
+    if (getOwner(i) == i && (running[i] || keep == -1 || !running[keep]))
+      keep = i;
+  vector<int> newRoots(numSearches, -1);
   vector<int> newSizes;
-  for (Vec2 v : pos.neighbors8())
-    if (v.inRectangle(bounds) && sectors[v] > -1 && sectors[v] <= maxSector) {
-      join(v, getNewSector());
-      newSizes.push_back(sizes[sectors[v]]);
+  for (auto& elem : visited) {
+    int search = getOwner(elem.second);
+    if (search == keep)
+      continue;
+    int node = newNode();
+    if (newRoots[search] == -1)
+      newRoots[search] = node;
+    else {
+      parent[node] = newRoots[search];
+      ++sizes[newRoots[search]];
+    }
+    nodes[elem.first] = node;
+    --sizes[root];
+  }
+  for (int node : newRoots)
+    if (node > -1)
+      newSizes.push_back(sizes[node]);
+  newSizes.push_back(sizes[root]);
+  Debug() << "Sectors size " << oldSize << " split into " << newSizes;
+}
+
+void Sectors::compact() {
+  parent.clear();
+  sizes.clear();
+  for (Vec2 v : bounds)
+    if (nodes[v] > -1)
+      nodes[v] = -2;
+  for (Vec2 v : bounds)
+    if (nodes[v] == -2) {
+      int root = newNode();
+      nodes[v] = root;
+      queue<Vec2> q;
+      q.push(v);
+      while (!q.empty()) {
+        Vec2 cur = q.front();
+        q.pop();
+        for (Vec2 dir : dirs8) {
+          Vec2 w = cur + dir;
+          if (w.inRectangle(bounds) && nodes[w] == -2) {
+            nodes[w] = newNode();
+            parent[nodes[w]] = root;
+            ++sizes[root];
+            q.push(w);
+          }
+        }
+      }
     }
-  Debug() << "Sectors size " << curNumber << " split into " << newSizes;
 }
 
 using namespace std;
@@ -105,7 +227,7 @@ using namespace std;
 void Sectors::dump() {
   for (int i : Range(bounds.getH())) {
     for (int j : Range(bounds.getW()))
-      cout << sectors[j][i] << " ";
+      cout << (nodes[j][i] > -1 ? find(nodes[j][i]) : -1) << " ";
     cout << endl;
   }
   cout << endl;
@@ -18,6 +18,9 @@
 
 #include "util.h"
 
+/** Keeps track of connected regions of passable squares. Adding a square is a union-find merge.
+  * Removing one only searches the map if the neighboring squares aren't connected around it,
+  * and even then only explores the smaller pieces of the split region.*/
 class Sectors {
   public:
   Sectors(Rectangle bounds);
@@ -30,11 +33,15 @@ class Sectors {
   SERIALIZATION_DECL(Sectors);
 
   private:
-  void setSector(Vec2, int);
-  int getNewSector();
-  void join(Vec2, int);
+  int newNode();
+  int find(int node) const;
+  void join(int node1, int node2);
+  vector<Vec2> getNeighborGroups(Vec2 pos) const;
+  void split(Vec2 pos, int root, const vector<Vec2>& groups);
+  void compact();
   Rectangle SERIAL(bounds);
-  Table<int> SERIAL(sectors);
+  Table<int> SERIAL(nodes);
+  mutable vector<int> SERIAL(parent);
   vector<int> SERIAL(sizes);
 };
 
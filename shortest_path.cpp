@@ -58,7 +58,8 @@ class DistanceTable {
   int counter = 1;
 };
 
-static DistanceTable distanceTable(Level::getMaxBounds());
+// levels are generated in parallel, so every thread searches in its own table
+static thread_local DistanceTable distanceTable(Level::getMaxBounds());
 
 const int margin = 15;
 
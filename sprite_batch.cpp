@@ -0,0 +1,106 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+#include "sprite_batch.h"
+
+SpriteBatch::SpriteBatch(Backend* b) : backend(b) {
+  setScreenSize(1, 1);
+}
+
+void SpriteBatch::setScreenSize(int width, int height) {
+  int w = max(1, (width + cellSize - 1) / cellSize);
+  int h = max(1, (height + cellSize - 1) / cellSize);
+  if (w != gridWidth || h != gridHeight || cells.empty()) {
+    CHECK(isEmpty());
+    gridWidth = w;
+    gridHeight = h;
+    cells = vector<vector<Entry>>(w * h);
+  }
+}
+
+Rectangle SpriteBatch::getCells(const Quad& q) const {
+  auto clampX = [&] (float x) { return max(0, min(gridWidth - 1, int(floor(x / cellSize)))); };
+  auto clampY = [&] (float y) { return max(0, min(gridHeight - 1, int(floor(y / cellSize)))); };
+  return Rectangle(clampX(q.x), clampY(q.y), clampX(q.x + q.w) + 1, clampY(q.y + q.h) + 1);
+}
+
+void SpriteBatch::add(int texture, const Quad& q) {
+  CHECK(texture >= 0);
+  if (texture >= lastBatch.size())
+    lastBatch.resize(texture + 1, -1);
+  float x2 = q.x + q.w;
+  float y2 = q.y + q.h;
+  // Find the last batch that has a quad overlapping this one. Quads that only touch don't overlap.
+  int top = -1;
+  Rectangle area = getCells(q);
+  for (Vec2 v : area)
+    for (const Entry& e : cells[v.x + v.y * gridWidth])
+      if (e.batch > top && e.x1 < x2 && q.x < e.x2 && e.y1 < y2 && q.y < e.y2)
+        top = e.batch;
+  int target = lastBatch[texture];
+  if (target == -1 || target < top) {
+    target = numBatches++;
+    if (batches.size() < numBatches)
+      batches.emplace_back();
+    batches[target].texture = texture;
+    batches[target].quads.clear();
+    lastBatch[texture] = target;
+  }
+  batches[target].quads.push_back(q);
+  for (Vec2 v : area) {
+    vector<Entry>& cell = cells[v.x + v.y * gridWidth];
+    if (cell.empty())
+      touchedCells.push_back(v.x + v.y * gridWidth);
+    cell.push_back({target, q.x, q.y, x2, y2});
+  }
+}
+
+void SpriteBatch::flush() {
+  for (int i : Range(numBatches))
+    backend->drawQuads(batches[i].texture, batches[i].quads);
+  numBatches = 0;
+  for (int& elem : lastBatch)
+    elem = -1;
+  for (int index : touchedCells)
+    cells[index].clear();
+  touchedCells.clear();
+}
+
+bool SpriteBatch::isEmpty() const {
+  return numBatches == 0;
+}
+
+void RecordingBackend::drawQuads(int texture, const vector<SpriteBatch::Quad>& quads) {
+  batches.push_back({texture, quads});
+  numQuads += quads.size();
+}
+
+int RecordingBackend::getNumQuads() const {
+  return numQuads;
+}
+
+int RecordingBackend::getNumBatches() const {
+  return batches.size();
+}
+
+const vector<RecordingBackend::Batch>& RecordingBackend::getBatches() const {
+  return batches;
+}
+
+void RecordingBackend::clear() {
+  batches.clear();
+  numQuads = 0;
+}
@@ -0,0 +1,94 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _SPRITE_BATCH_H
+#define _SPRITE_BATCH_H
+
+#include "util.h"
+
+/**
+  * Collects textured quads drawn during a frame and merges those that share a texture into batches,
+  * which are then drawn with one call each. A quad only joins an earlier batch if it doesn't overlap
+  * anything that was queued after that batch, so the result looks the same as drawing the quads one by one.
+  */
+class SpriteBatch {
+  public:
+  struct Quad {
+    float x, y, w, h;
+    float texX, texY, texW, texH;
+    unsigned char r, g, b, a;
+  };
+
+  class Backend {
+    public:
+    /** Draws quads that all use the given texture, in order.*/
+    virtual void drawQuads(int texture, const vector<Quad>&) = 0;
+    virtual ~Backend() {}
+  };
+
+  SpriteBatch(Backend*);
+
+  /** Sets the area in which quads are usually drawn. Quads outside of it are still handled correctly.*/
+  void setScreenSize(int width, int height);
+
+  void add(int texture, const Quad&);
+
+  /** Draws all queued quads.*/
+  void flush();
+
+  bool isEmpty() const;
+
+  private:
+  struct Batch {
+    int texture;
+    vector<Quad> quads;
+  };
+  struct Entry {
+    int batch;
+    float x1, y1, x2, y2;
+  };
+  Rectangle getCells(const Quad&) const;
+  Backend* backend;
+  const static int cellSize = 32;
+  int gridWidth = 1;
+  int gridHeight = 1;
+  vector<vector<Entry>> cells;
+  vector<int> touchedCells;
+  vector<Batch> batches;
+  int numBatches = 0;
+  vector<int> lastBatch;
+};
+
+/** Backend that doesn't draw anything, only records what it's given.*/
+class RecordingBackend : public SpriteBatch::Backend {
+  public:
+  virtual void drawQuads(int texture, const vector<SpriteBatch::Quad>&) override;
+
+  int getNumQuads() const;
+  int getNumBatches() const;
+  void clear();
+
+  struct Batch {
+    int texture;
+    vector<SpriteBatch::Quad> quads;
+  };
+  const vector<Batch>& getBatches() const;
+
+  private:
+  vector<Batch> batches;
+  int numQuads = 0;
+};
+
+#endif
@@ -20,26 +20,43 @@
 #include "level.h"
 
 template <class Archive> 
-void Square::serialize(Archive& ar, const unsigned int version) { 
+void Square::Prototype::serialize(Archive& ar, const unsigned int version) { 
+  ar& BOOST_SERIALIZATION_NVP(name)
+    & BOOST_SERIALIZATION_NVP(vision)
+    & BOOST_SERIALIZATION_NVP(hide)
+    & BOOST_SERIALIZATION_NVP(strength)
+    & BOOST_SERIALIZATION_NVP(flamability)
+    & BOOST_SERIALIZATION_NVP(constructions)
+    & BOOST_SERIALIZATION_NVP(ticking);
+}
+
+template <class Archive> 
+void Square::Extra::serialize(Archive& ar, const unsigned int version) { 
   ar& SVAR(inventory)
-    & SVAR(name)
+    & SVAR(triggers)
+    & SVAR(travelDir)
+    & SVAR(landingLink)
+    & SVAR(fire)
+    & SVAR(constructionProgress);
+  CHECK_SERIAL;
+}
+
+template <class Archive> 
+void Square::serialize(Archive& ar, const unsigned int version) { 
+  Prototype proto;
+  if (Archive::is_saving::value)
+    proto = *prototype;
+  ar& boost::serialization::make_nvp("prototype", proto)
+    & SVAR(extra)
     & SVAR(level)
     & SVAR(position)
     & SVAR(creature)
-    & SVAR(triggers)
     & SVAR(viewObject)
     & SVAR(backgroundObject)
-    & SVAR(vision)
-    & SVAR(hide)
-    & SVAR(strength)
     & SVAR(height)
-    & SVAR(travelDir)
-    & SVAR(landingLink)
-    & SVAR(fire)
-    & SVAR(poisonGas)
-    & SVAR(constructions)
-    & SVAR(ticking)
     & SVAR(fog);
+  if (Archive::is_loading::value)
+    prototype = intern(proto);
   CHECK_SERIAL;
 }
 
@@ -54,13 +71,48 @@ SERIALIZABLE(SolidSquare);
 
 Square::Square(const ViewObject& vo, const string& n, Vision* v, bool canHide, int s, double f,
     map<SquareType, int> construct, bool tick) 
-    : name(n), viewObject(vo), vision(v), hide(canHide), strength(s), fire(strength, f),
-    constructions(construct), ticking(tick) {
+    : viewObject(vo), prototype(intern({n, v, canHide, s, f, construct, tick})) {
+  updateVersion();
+}
+
+bool Square::Prototype::operator < (const Prototype& p) const {
+  return std::tie(name, vision, hide, strength, flamability, constructions, ticking)
+      < std::tie(p.name, p.vision, p.hide, p.strength, p.flamability, p.constructions, p.ticking);
+}
+
+// every square constructor interns its prototype, also on the level generating threads
+static std::mutex prototypeMutex;
+
+const Square::Prototype* Square::intern(const Prototype& p) {
+  static set<Prototype> prototypes;
+  std::unique_lock<std::mutex> lock(prototypeMutex);
+  return &*prototypes.insert(p).first;
+}
+
+Square::Extra::Extra(const Prototype& p) : fire(p.strength, p.flamability) {
+}
+
+Square::Extra& Square::getExtra() {
+  if (!extra)
+    extra.reset(new Extra(*prototype));
+  return *extra;
+}
+
+// squares of different levels are made on several threads
+static std::atomic<int> versionCounter(0);
+
+void Square::updateVersion() {
+  version = ++versionCounter;
+}
+
+int Square::getVersion() const {
+  return version;
 }
 
 void Square::putCreature(Creature* c) {
   CHECK(canEnter(c));
   creature = c;
+  updateVersion();
   onEnter(c);
 }
 
@@ -73,23 +125,28 @@ Vec2 Square::getPosition() const {
 }
 
 string Square::getName() const {
-  return name;
+  return prototype->name;
 }
 
 void Square::setName(const string& s) {
-  name = s;
+  Prototype p(*prototype);
+  p.name = s;
+  prototype = intern(p);
 }
 
 void Square::setLandingLink(StairDirection direction, StairKey key) {
-  landingLink = make_pair(direction, key);
+  getExtra().landingLink = make_pair(direction, key);
 }
 
 bool Square::isLandingSquare(StairDirection direction, StairKey key) {
-  return landingLink == make_pair(direction, key);
+  return extra && extra->landingLink == make_pair(direction, key);
 }
 
 Optional<pair<StairDirection, StairKey>> Square::getLandingLink() const {
-  return landingLink;
+  if (extra)
+    return extra->landingLink;
+  else
+    return Nothing();
 }
 
 double Square::getLightEmission() const {
@@ -99,20 +156,22 @@ double Square::getLightEmission() const {
 void Square::setHeight(double h) {
   viewObject.setHeight(h);
   height = h;
+  updateVersion();
 }
 
 void Square::addTravelDir(Vec2 dir) {
+  vector<Vec2>& travelDir = getExtra().travelDir;
   if (!findElement(travelDir, dir))
     travelDir.push_back(dir);
 }
 
 bool Square::canConstruct(SquareType type) const {
-  return constructions.count(type);
+  return prototype->constructions.count(type);
 }
 
 bool Square::construct(SquareType type) {
   CHECK(canConstruct(type));
-  if (--constructions[type] <= 0) {
+  if (++getExtra().constructionProgress[type] >= prototype->constructions.at(type)) {
     PSquare newSquare = PSquare(SquareFactory::get(type));
 /*    if (creature && !newSquare->canEnter(creature))
       return false;*/
@@ -135,16 +194,21 @@ void Square::burnOut() {
 }
 
 const vector<Vec2>& Square::getTravelDir() const {
-  return travelDir;
+  static const vector<Vec2> none;
+  if (extra)
+    return extra->travelDir;
+  else
+    return none;
 }
 
 void Square::putCreatureSilently(Creature* c) {
   creature = c;
+  updateVersion();
 }
 
 void Square::setLevel(Level* l) {
   level = l;
-  if (ticking || !inventory.isEmpty())
+  if (needsTicking())
     level->addTickingSquare(position);
 }
 
@@ -158,20 +222,25 @@ Level* Square::getLevel() {
 
 void Square::setFog(double val) {
   fog = val;
+  updateVersion();
 }
 
 void Square::tick(double time) {
-  if (!inventory.isEmpty())
+  if (extra && !extra->inventory.isEmpty()) {
+    Inventory& inventory = extra->inventory;
+    Item* topItem = getTopItem();
+    ViewId topId = topItem->getViewObject().id();
     for (Item* item : inventory.getItems()) {
       item->tick(time, level, position);
       if (item->isDiscarded())
         inventory.removeItem(item);
     }
-  poisonGas.tick(level, position);
-  if (creature && poisonGas.getAmount() > 0.2) {
-    creature->poisonWithGas(min(1.0, poisonGas.getAmount()));
+    if (getTopItem() != topItem || topItem->getViewObject().id() != topId)
+      updateVersion();
   }
-  if (fire.isBurning()) {
+  if (isBurning()) {
+    updateVersion();
+    Fire& fire = extra->fire;
     viewObject.setBurning(fire.getSize());
     Debug() << getName() << " burning " << fire.getSize();
     for (Vec2 v : position.neighbors8(true))
@@ -187,14 +256,19 @@ void Square::tick(double time) {
       creature->setOnFire(fire.getSize());
     for (Item* it : getItems())
       it->setOnFire(fire.getSize(), level, position);
-    for (Trigger* t : extractRefs(triggers))
+    for (Trigger* t : getTriggers())
       t->setOnFire(fire.getSize());
   }
-  for (Trigger* t : extractRefs(triggers))
+  for (Trigger* t : getTriggers())
     t->tick(time);
   tickSpecial(time);
 }
 
+bool Square::needsTicking() const {
+  return prototype->ticking || needsTickingSpecial() || (extra && (!extra->inventory.isEmpty()
+      || !extra->triggers.empty() || extra->fire.isBurning()));
+}
+
 bool Square::itemLands(vector<Item*> item, const Attack& attack) {
   if (creature) {
     if (!creature->dodgeAttack(attack))
@@ -207,7 +281,7 @@ bool Square::itemLands(vector<Item*> item, const Attack& attack) {
       return false;
     }
   }
-  for (PTrigger& t : triggers)
+  for (Trigger* t : getTriggers())
     if (t->interceptsFlyingItem(item[0]))
       return true;
   return false;
@@ -224,7 +298,7 @@ void Square::onItemLands(vector<PItem> item, const Attack& attack, int remaining
       dropItems(std::move(item));
     return;
   }
-  for (PTrigger& t : triggers)
+  for (Trigger* t : getTriggers())
     if (t->interceptsFlyingItem(item[0].get())) {
       t->onInterceptFlyingItem(std::move(item), attack, remainingDist, dir, vision);
       return;
@@ -248,12 +322,15 @@ bool Square::canEnterSpecial(const Creature* c) const {
 }
 
 void Square::setOnFire(double amount) {
-  bool burning = fire.isBurning();
-  fire.set(amount);
-  if (!burning && fire.isBurning()) {
+  bool burning = isBurning();
+  // only flamable squares need a fire of their own
+  if (prototype->flamability > 0)
+    getExtra().fire.set(amount);
+  if (!burning && isBurning()) {
+    updateVersion();
     level->addTickingSquare(position);
     level->globalMessage(position, "The " + getName() + " catches fire.");
-    viewObject.setBurning(fire.getSize());
+    viewObject.setBurning(extra->fire.getSize());
   }
   if (creature)
     creature->setOnFire(amount);
@@ -263,17 +340,24 @@ void Square::setOnFire(double amount) {
 
 void Square::addPoisonGas(double amount) {
   if (canSeeThru()) {
-    poisonGas.addAmount(amount);
-    level->addTickingSquare(position);
+    level->addPoisonGas(position, amount);
+    updateVersion();
   }
 }
 
 double Square::getPoisonGasAmount() const {
-  return poisonGas.getAmount();
+  return level->getPoisonGasAmount(position);
+}
+
+void Square::tickPoisonGas() {
+  updateVersion();
+  double amount = getPoisonGasAmount();
+  if (creature && amount > 0.2)
+    creature->poisonWithGas(min(1.0, amount));
 }
 
 bool Square::isBurning() const {
-  return fire.isBurning();
+  return extra && extra->fire.isBurning();
 }
 
 const ViewObject& Square::getViewObject() const {
@@ -285,11 +369,13 @@ Optional<ViewObject> Square::getBackgroundObject() const {
 }
 
 void Square::setBackground(const Square* square) {
-  if (viewObject.layer() != ViewLayer::FLOOR_BACKGROUND) {
-    const ViewObject& obj = square->backgroundObject ? (*square->backgroundObject) : square->viewObject;
-    if (obj.layer() == ViewLayer::FLOOR_BACKGROUND)
-      backgroundObject = obj;
-  }
+  setBackground(square->backgroundObject ? (*square->backgroundObject) : square->viewObject);
+}
+
+void Square::setBackground(const ViewObject& obj) {
+  if (viewObject.layer() != ViewLayer::FLOOR_BACKGROUND && obj.layer() == ViewLayer::FLOOR_BACKGROUND)
+    backgroundObject = obj;
+  updateVersion();
 }
 
 static ViewObject addFire(const ViewObject& obj, double fire) {
@@ -300,9 +386,11 @@ static ViewObject addFire(const ViewObject& obj, double fire) {
 
 ViewIndex Square::getViewIndex(const CreatureView* c) const {
   double fireSize = 0;
-  for (Item* it : inventory.getItems())
-    fireSize = max(fireSize, it->getFireSize());
-  fireSize = max(fireSize, fire.getSize());
+  if (extra) {
+    for (Item* it : extra->inventory.getItems())
+      fireSize = max(fireSize, it->getFireSize());
+    fireSize = max(fireSize, extra->fire.getSize());
+  }
   ViewIndex ret;
   if (creature && (c->canSee(creature) || creature->isPlayer())) {
     ret.insert(addFire(creature->getViewObject(), fireSize));
@@ -313,7 +401,7 @@ ViewIndex Square::getViewIndex(const CreatureView* c) const {
     if (backgroundObject)
       ret.insert(*backgroundObject);
     ret.insert(getViewObject());
-    for (const PTrigger& t : triggers)
+    for (Trigger* t : getTriggers())
       if (auto obj = t->getViewObject(c))
         ret.insert(addFire(*obj, fireSize));
     if (Item* it = getTopItem())
@@ -321,8 +409,9 @@ ViewIndex Square::getViewIndex(const CreatureView* c) const {
   }
   if (c->canSee(position)) {
     ret.addHighlight(HighlightType::NIGHT, 1.0 - level->getLight(position));
-    if (poisonGas.getAmount() > 0)
-      ret.addHighlight(HighlightType::POISON_GAS, min(1.0, poisonGas.getAmount()));
+    double gas = getPoisonGasAmount();
+    if (gas > 0)
+      ret.addHighlight(HighlightType::POISON_GAS, min(1.0, gas));
     if (fog)
       ret.addHighlight(HighlightType::FOG, fog);
   }
@@ -330,7 +419,7 @@ ViewIndex Square::getViewIndex(const CreatureView* c) const {
 }
 
 void Square::onEnter(Creature* c) {
-  for (Trigger* t : extractRefs(triggers))
+  for (Trigger* t : getTriggers())
     t->onCreatureEnter(c);
   onEnterSpecial(c);
 }
@@ -338,7 +427,8 @@ void Square::onEnter(Creature* c) {
 void Square::dropItem(PItem item) {
   if (level)  // if level == null, then it's being constructed, square will be added later
     level->addTickingSquare(getPosition());
-  inventory.addItem(std::move(item));
+  getExtra().inventory.addItem(std::move(item));
+  updateVersion();
 }
 
 void Square::dropItems(vector<PItem> items) {
@@ -347,7 +437,7 @@ void Square::dropItems(vector<PItem> items) {
 }
 
 bool Square::hasItem(Item* it) const {
-  return inventory.hasItem(it);
+  return extra && extra->inventory.hasItem(it);
 }
 
 Creature* Square::getCreature() {
@@ -356,25 +446,33 @@ Creature* Square::getCreature() {
 
 void Square::addTrigger(PTrigger t) {
   level->addTickingSquare(position);
-  triggers.push_back(std::move(t));
+  getExtra().triggers.push_back(std::move(t));
+  updateVersion();
 }
 
 const vector<Trigger*> Square::getTriggers() const {
-  return extractRefs(triggers);
+  if (extra)
+    return extractRefs(extra->triggers);
+  else
+    return {};
 }
 
 PTrigger Square::removeTrigger(Trigger* trigger) {
-  for (PTrigger& t : triggers)
-    if (t.get() == trigger) {
-      PTrigger ret = std::move(t);
-      removeElement(triggers, t);
-      return ret;
-    }
+  if (extra)
+    for (PTrigger& t : extra->triggers)
+      if (t.get() == trigger) {
+        PTrigger ret = std::move(t);
+        removeElement(extra->triggers, t);
+        updateVersion();
+        return ret;
+      }
   return nullptr;
 }
 
 void Square::removeTriggers() {
-  triggers.clear();
+  if (extra)
+    extra->triggers.clear();
+  updateVersion();
 }
 
 const Creature* Square::getCreature() const {
@@ -384,6 +482,7 @@ const Creature* Square::getCreature() const {
 void Square::removeCreature() {
   CHECK(creature);
   creature = 0;
+  updateVersion();
 }
 
 bool SolidSquare::canEnterSpecial(const Creature*) const {
@@ -391,25 +490,29 @@ bool SolidSquare::canEnterSpecial(const Creature*) const {
 }
 
 bool Square::canSeeThru(Vision* v) const {
+  Vision* vision = prototype->vision;
   return vision && (v == vision || v->getInheritedFov() == vision);
 }
 
 void Square::setVision(Vision* v) {
-  vision = v;
+  Prototype p(*prototype);
+  p.vision = v;
+  prototype = intern(p);
+  updateVersion();
 }
 
 bool Square::canHide() const {
-  return hide;
+  return prototype->hide;
 }
 
 int Square::getStrength() const {
-  return strength;
+  return prototype->strength;
 }
 
 Item* Square::getTopItem() const {
   Item* last = nullptr;
-  if (!inventory.isEmpty())
-  for (Item* it : inventory.getItems()) {
+  if (extra && !extra->inventory.isEmpty())
+  for (Item* it : extra->inventory.getItems()) {
     last = it;
     if (it->getViewObject().layer() == ViewLayer::LARGE_ITEM)
       return it;
@@ -418,14 +521,19 @@ Item* Square::getTopItem() const {
 }
 
 vector<Item*> Square::getItems(function<bool (Item*)> predicate) {
-  return inventory.getItems(predicate);
+  if (extra)
+    return extra->inventory.getItems(predicate);
+  else
+    return {};
 }
 
 PItem Square::removeItem(Item* it) {
-  return inventory.removeItem(it);
+  updateVersion();
+  return getExtra().inventory.removeItem(it);
 }
 
 vector<PItem> Square::removeItems(vector<Item*> it) {
-  return inventory.removeItems(it);
+  updateVersion();
+  return getExtra().inventory.removeItems(it);
 }
 
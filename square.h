@@ -23,7 +23,6 @@
 #include "inventory.h"
 #include "trigger.h"
 #include "view_index.h"
-#include "poison_gas.h"
 #include "vision.h"
 
 class Level;
@@ -115,6 +114,9 @@ class Square {
   /** Returns the amount of poison gas on this square.*/
   double getPoisonGasAmount() const;
 
+  /** Called every turn when the amount of poison gas on this square has changed.*/
+  void tickPoisonGas();
+
   /** Sets the level this square is on.*/
   void setLevel(Level*);
 
@@ -168,6 +170,9 @@ class Square {
       For this method to be called, the square coordinates must be added with Level::addTickingSquare().*/
   void tick(double time);
 
+  /** Checks if anything on the square changes over time. Once it doesn't, the square is no longer ticked.*/
+  bool needsTicking() const;
+
   virtual bool canLock() const { return false; }
   virtual bool isLocked() const { FAIL << "BAD"; return false; }
   virtual void lock() { FAIL << "BAD"; }
@@ -175,8 +180,13 @@ class Square {
   const ViewObject& getViewObject() const;
   Optional<ViewObject> getBackgroundObject() const;
   void setBackground(const Square*);
+  void setBackground(const ViewObject&);
   ViewIndex getViewIndex(const CreatureView* c) const;
 
+  /** Returns a stamp that changes whenever the square's creature, items or appearance change.
+    * Stamps are unique across all squares, so a replaced square never reuses a stamp.*/
+  int getVersion() const;
+
   bool itemLands(vector<Item*> item, const Attack& attack);
   virtual bool itemBounces(Item* item, Vision*) const;
   void onItemLands(vector<PItem> item, const Attack& attack, int remainingDist, Vec2 dir, Vision*);
@@ -200,30 +210,55 @@ class Square {
   virtual bool canEnterSpecial(const Creature*) const;
   virtual void onEnterSpecial(Creature*) {}
   virtual void tickSpecial(double time) {}
+  virtual bool needsTickingSpecial() const { return false; }
   Level* getLevel();
-  Inventory SERIAL(inventory);
-  string SERIAL(name);
+  void updateVersion();
   ViewObject SERIAL(viewObject);
 
   private:
+  /** The constructor parameters. Squares made with the same parameters share one instance, which never
+    * changes, so a square that is renamed or changes vision switches to another one.*/
+  struct Prototype {
+    string name;
+    Vision* vision;
+    bool hide;
+    int strength;
+    double flamability;
+    map<SquareType, int> constructions;
+    bool ticking;
+
+    bool operator < (const Prototype&) const;
+
+    template <class Archive> 
+    void serialize(Archive& ar, const unsigned int version);
+  };
+  static const Prototype* intern(const Prototype&);
+
+  /** State that most squares don't have. It's allocated when first needed.*/
+  struct Extra {
+    Extra(const Prototype&);
+    Inventory SERIAL(inventory);
+    vector<PTrigger> SERIAL(triggers);
+    vector<Vec2> SERIAL(travelDir);
+    Optional<pair<StairDirection, StairKey>> SERIAL(landingLink);
+    Fire SERIAL(fire);
+    /** How many times each construction has been worked on.*/
+    map<SquareType, int> SERIAL(constructionProgress);
+
+    SERIALIZATION_DECL(Extra);
+  };
+  Extra& getExtra();
   Item* getTopItem() const;
 
+  const Prototype* prototype;
+  unique_ptr<Extra> SERIAL(extra);
   Level* SERIAL2(level, nullptr);
   Vec2 SERIAL(position);
   Creature* SERIAL2(creature, nullptr);
-  vector<PTrigger> SERIAL(triggers);
   Optional<ViewObject> SERIAL(backgroundObject);
-  Vision* SERIAL(vision);
-  bool SERIAL(hide);
-  int SERIAL(strength);
   double SERIAL(height);
-  vector<Vec2> SERIAL(travelDir);
-  Optional<pair<StairDirection, StairKey>> SERIAL(landingLink);
-  Fire SERIAL(fire);
-  PoisonGas SERIAL(poisonGas);
-  map<SquareType, int> SERIAL(constructions);
-  bool SERIAL(ticking);
   double SERIAL2(fog, 0);
+  int version = 0;
 };
 
 class SolidSquare : public Square {
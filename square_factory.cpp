@@ -237,6 +237,7 @@ class Chest : public Square {
     c->playerMessage("You open the " + getName());
     opened = true;
     viewObject = openedObject;
+    updateVersion();
     if (!Random.roll(5)) {
       c->playerMessage(msgItem);
       vector<PItem> items = itemFactory.random();
@@ -453,6 +454,7 @@ class TribeDoor : public Door {
       viewObject.setModifier(ViewObject::LOCKED);
     else
       viewObject.removeModifier(ViewObject::LOCKED);
+    updateVersion();
   }
 
   template <class Archive> 
@@ -572,6 +574,10 @@ class Bed : public Furniture {
       getCreature()->heal(0.005);
   }
 
+  virtual bool needsTickingSpecial() const override {
+    return getCreature() && getCreature()->isAffected(LastingEffect::SLEEP);
+  }
+
   template <class Archive> 
   void serialize(Archive& ar, const unsigned int version) {
     ar & SUBCLASS(Furniture);
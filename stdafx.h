@@ -36,6 +36,12 @@
 #include <stdexcept>
 #include <tuple>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+#include <cstdint>
+#include <chrono>
 #include <stack>
 #include <typeinfo>
 #include <tuple>
@@ -81,6 +87,7 @@ using std::string;
 
 using std::queue;
 using std::unique_ptr;
+using std::shared_ptr;
 using std::default_random_engine;
 using std::function;
 using std::initializer_list;
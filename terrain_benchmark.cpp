@@ -0,0 +1,46 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "terrain_benchmark.h"
+#include "level.h"
+#include "level_maker.h"
+
+TerrainBenchmark::TerrainBenchmark(vector<int> s, int n) : sizes(s), numRuns(n) {
+  CHECK(numRuns > 0);
+}
+
+void TerrainBenchmark::run() {
+  results.clear();
+  LevelMaker* maker = LevelMaker::terrain();
+  for (int size : sizes) {
+    double total = 0;
+    for (int i : Range(numRuns)) {
+      Random.init(i);
+      Level::Builder builder(size, size, "Terrain benchmark");
+      auto start = std::chrono::steady_clock::now();
+      builder.make(maker);
+      total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    results.push_back(total / numRuns);
+  }
+}
+
+void TerrainBenchmark::printResults(std::ostream& out) const {
+  out << "size,runs,ms" << endl;
+  for (int i : All(results))
+    out << sizes[i] << "," << numRuns << "," << results[i] << endl;
+}
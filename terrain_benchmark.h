@@ -0,0 +1,41 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _TERRAIN_BENCHMARK_H
+#define _TERRAIN_BENCHMARK_H
+
+#include "util.h"
+
+/**
+  * Measures how long it takes to generate the terrain of square worlds of given sizes: the height map,
+  * its classification into mountains, hills, lowlands and lakes, and the forests.
+  */
+class TerrainBenchmark {
+  public:
+  TerrainBenchmark(vector<int> sizes, int numRuns);
+
+  /** Runs the benchmark. Square types have to be initialized beforehand.*/
+  void run();
+
+  /** Prints the average time per map of each size as CSV.*/
+  void printResults(std::ostream&) const;
+
+  private:
+  vector<int> sizes;
+  int numRuns;
+  vector<double> results;
+};
+
+#endif
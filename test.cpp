@@ -21,6 +21,27 @@
 #include "level_maker.h"
 #include "test.h"
 #include "sectors.h"
+#include "markov_chain.h"
+#include "sprite_batch.h"
+#include "map_memory.h"
+#include "render_thread.h"
+#include "minimap_tiles.h"
+#include "frame_stats.h"
+#include "world_builder.h"
+#include "model.h"
+#include "name_generator.h"
+#include "item_factory.h"
+#include "item.h"
+#include "creature.h"
+#include "tribe.h"
+#include "skill.h"
+#include "technology.h"
+#include "vision.h"
+#include "pantheon.h"
+#include "square.h"
+#include "light_map.h"
+#include "poison_gas.h"
+#include "field_of_view.h"
 
 void testStringConvertion() {
   CHECK(convertToString(1234) == "1234");
@@ -148,6 +169,526 @@ void testRandom() {
   CHECK(chooseRandom<string>({"pokpok", "kwakwa", "pikpik"}, { 1, 0, 3}, 2) == "pikpik");
 }
 
+void testRandomStreams() {
+  RandomGen gen1, gen2;
+  gen1.init(123);
+  gen2.init(123);
+  for (int i : Range(1000)) {
+    int a = gen1.getRandom(-5, 7);
+    CHECK(a >= -5 && a < 7);
+    CHECKEQ(a, gen2.getRandom(-5, 7));
+    double d = gen1.getDouble();
+    CHECK(d >= 0 && d < 1);
+    CHECK(d == gen2.getDouble());
+  }
+  // Named streams don't depend on how much was drawn from the parent, and differ from each other.
+  RandomGen fresh;
+  fresh.init(123);
+  RandomGen stream = fresh.getStream("level");
+  CHECKEQ(stream.getRandom(1 << 30), gen1.getStream("level").getRandom(1 << 30));
+  CHECK(fresh.getStream("level").getRandom(1 << 30) != fresh.getStream("creature").getRandom(1 << 30));
+  CHECK(fresh.getStream(1).getRandom(1 << 30) != fresh.getStream(2).getRandom(1 << 30));
+  // Splitting advances the parent by exactly one number.
+  RandomGen split = gen1.split();
+  gen2.getRandom(1);
+  CHECKEQ(gen1.getRandom(1 << 30), gen2.getRandom(1 << 30));
+  CHECK(split.getRandom(1 << 30) != gen1.getRandom(1 << 30));
+  vector<int> hist(10, 0);
+  for (int i : Range(100000))
+    ++hist[gen1.getRandom(10)];
+  for (int n : hist)
+    CHECK(n > 9000 && n < 11000) << n;
+}
+
+void testMarkovChain() {
+  Random.init(2345);
+  MarkovChain<MinionTask> chain(MinionTask::SLEEP, {
+      {MinionTask::SLEEP, {{ MinionTask::TRAIN, 0.6}, { MinionTask::WORKSHOP, 0.3}}},
+      {MinionTask::WORKSHOP, {{ MinionTask::SLEEP, 0.25}}},
+      {MinionTask::TRAIN, {}}});
+  CHECK(chain.getInitialState() == MinionTask::SLEEP);
+  CHECK(chain.containsState(MinionTask::WORKSHOP));
+  CHECK(!chain.containsState(MinionTask::STUDY));
+  CHECK(!chain.getNextOther(MinionTask::TRAIN));
+  CHECK(chain.getNext(MinionTask::TRAIN) == MinionTask::TRAIN);
+  map<MinionTask, int> next, nextOther, workshop;
+  int numSamples = 100000;
+  for (int i : Range(numSamples)) {
+    ++next[chain.getNext(MinionTask::SLEEP)];
+    ++nextOther[*chain.getNextOther(MinionTask::SLEEP)];
+    ++workshop[chain.getNext(MinionTask::WORKSHOP)];
+  }
+  auto checkFreq = [=] (int count, double p) { CHECK(fabs(double(count) / numSamples - p) < 0.01) << count; };
+  checkFreq(next[MinionTask::TRAIN], 0.6);
+  checkFreq(next[MinionTask::WORKSHOP], 0.3);
+  checkFreq(next[MinionTask::SLEEP], 0.1);
+  checkFreq(nextOther[MinionTask::TRAIN], 2.0 / 3);
+  checkFreq(nextOther[MinionTask::WORKSHOP], 1.0 / 3);
+  CHECK(!nextOther.count(MinionTask::SLEEP));
+  checkFreq(workshop[MinionTask::SLEEP], 0.25);
+  checkFreq(workshop[MinionTask::WORKSHOP], 0.75);
+}
+
+static SpriteBatch::Quad getQuad(float x, float y, float w, float h, int id = 0) {
+  return {x, y, w, h, 0, float(id), w, h, 255, 255, 255, 255};
+}
+
+void testSpriteBatchOrder() {
+  RecordingBackend backend;
+  SpriteBatch batch(&backend);
+  batch.setScreenSize(100, 100);
+  batch.add(0, getQuad(10, 10, 20, 20));
+  batch.add(1, getQuad(15, 15, 20, 20));
+  batch.add(0, getQuad(20, 20, 20, 20));
+  batch.flush();
+  CHECKEQ(backend.getNumBatches(), 3);
+  CHECKEQ(backend.getNumQuads(), 3);
+  CHECKEQ(backend.getBatches()[1].texture, 1);
+  backend.clear();
+  batch.add(0, getQuad(0, 0, 20, 20));
+  batch.add(1, getQuad(0, 20, 20, 20));
+  batch.add(0, getQuad(20, 0, 20, 20));
+  batch.add(1, getQuad(-50, 300, 20, 20));
+  batch.flush();
+  CHECKEQ(backend.getNumBatches(), 2);
+  CHECKEQ(backend.getNumQuads(), 4);
+  CHECKEQ(int(backend.getBatches()[0].quads.size()), 2);
+}
+
+void testSpriteBatchMap() {
+  Random.init(3456);
+  RecordingBackend backend;
+  SpriteBatch batch(&backend);
+  int sz = 36;
+  batch.setScreenSize(50 * sz, 30 * sz);
+  vector<pair<int, SpriteBatch::Quad>> submitted;
+  auto add = [&] (int texture, SpriteBatch::Quad q) {
+    q.texY = submitted.size();
+    submitted.emplace_back(texture, q);
+    batch.add(texture, q);
+  };
+  for (int y : Range(30))
+    for (int x : Range(50)) {
+      add(1, getQuad(x * sz, y * sz, sz, sz));
+      if (Random.roll(5))
+        add(5, getQuad(x * sz, y * sz, sz, sz));
+      if (Random.roll(10)) {
+        add(0, getQuad(x * sz, y * sz - 2, sz, sz));
+        add(1, getQuad(x * sz, y * sz - 6, sz, sz));
+      }
+      if (Random.roll(20))
+        add(2, getQuad(x * sz, y * sz, sz, sz));
+    }
+  batch.flush();
+  CHECKEQ(backend.getNumQuads(), int(submitted.size()));
+  CHECK(backend.getNumBatches() * 4 < submitted.size()) << backend.getNumBatches();
+  vector<int> drawn(submitted.size());
+  int cnt = 0;
+  for (auto& b : backend.getBatches())
+    for (auto& q : b.quads) {
+      CHECKEQ(submitted[int(q.texY)].first, b.texture);
+      drawn[int(q.texY)] = cnt++;
+    }
+  auto overlap = [] (const SpriteBatch::Quad& a, const SpriteBatch::Quad& b) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h && b.y < a.y + a.h;
+  };
+  for (int i : All(submitted))
+    for (int j : Range(i + 1, submitted.size()))
+      if (overlap(submitted[i].second, submitted[j].second))
+        CHECK(drawn[i] < drawn[j]) << i << " " << j;
+}
+
+void testViewIndex() {
+  ViewIndex index;
+  CHECK(index.isEmpty());
+  index.insert(ViewObject(ViewId::FLOOR, ViewLayer::FLOOR, "floor"));
+  index.insert(ViewObject(ViewId::SWORD, ViewLayer::ITEM, "sword"));
+  index.addHighlight(HighlightType::NIGHT, 0.25);
+  index.addHighlight(HighlightType::NIGHT, 0.5);
+  index.addHighlight(HighlightType::NIGHT, 0.3);
+  CHECKEQ(index.getHighlight(HighlightType::NIGHT), 0.5);
+  CHECK(!index.hasHighlight(HighlightType::FOG));
+  CHECKEQ(index.getObject(ViewLayer::FLOOR).getBareDescription(), "Floor");
+  CHECK(index.getTopObject(allLayers)->id() == ViewId::SWORD);
+  index.removeObject(ViewLayer::ITEM);
+  CHECK(index.getTopObject(allLayers)->id() == ViewId::FLOOR);
+  ViewIndex index2;
+  index2.insert(ViewObject(ViewId::FLOOR, ViewLayer::FLOOR, "floor"));
+  CHECK(!(index == index2));
+  index2.addHighlight(HighlightType::NIGHT, 0.5);
+  CHECK(index == index2);
+  CHECK(index.getHash() == index2.getHash());
+}
+
+void testMapMemory() {
+  MapMemory memory;
+  ViewIndex floor;
+  floor.insert(ViewObject(ViewId::FLOOR, ViewLayer::FLOOR, "floor"));
+  floor.insert(ViewObject(ViewId::GOBLIN, ViewLayer::CREATURE, "goblin"));
+  for (Vec2 v : Rectangle(100, 100))
+    memory.update(v, floor);
+  CHECK(!memory.getViewIndex(Vec2(5, 5)).hasObject(ViewLayer::CREATURE));
+  CHECK(memory.getViewIndex(Vec2(5, 5)).hasHighlight(HighlightType::MEMORY));
+  CHECK(&memory.getViewIndex(Vec2(5, 5)) == &memory.getViewIndex(Vec2(50, 50)));
+  int version = memory.getVersion(Vec2(3, 3));
+  memory.addObject(Vec2(3, 3), ViewObject(ViewId::SWORD, ViewLayer::ITEM, "sword"));
+  CHECK(memory.getVersion(Vec2(3, 3)) != version);
+  CHECK(memory.getViewIndex(Vec2(3, 3)).hasObject(ViewLayer::ITEM));
+  CHECK(!memory.getViewIndex(Vec2(4, 4)).hasObject(ViewLayer::ITEM));
+  memory.clearSquare(Vec2(3, 3));
+  CHECK(!memory.hasViewIndex(Vec2(3, 3)));
+  CHECK(!memory.hasViewIndex(Vec2(300, 300)));
+  MapMemory copy(memory);
+  CHECK(copy.getViewIndex(Vec2(5, 5)) == memory.getViewIndex(Vec2(5, 5)));
+  copy.addObject(Vec2(5, 5), ViewObject(ViewId::SWORD, ViewLayer::ITEM, "sword"));
+  CHECK(copy.getViewIndex(Vec2(5, 5)).hasObject(ViewLayer::ITEM));
+  CHECK(!memory.getViewIndex(Vec2(5, 5)).hasObject(ViewLayer::ITEM));
+  CHECK(!copy.getViewIndex(Vec2(6, 5)).hasObject(ViewLayer::ITEM));
+}
+
+void testMapMemoryBounds() {
+  MapMemory memory(Rectangle(5, 5, 40, 30));
+  ViewIndex floor;
+  floor.insert(ViewObject(ViewId::FLOOR, ViewLayer::FLOOR, "floor"));
+  memory.update(Vec2(5, 5), floor);
+  memory.update(Vec2(39, 29), floor);
+  memory.addObject(Vec2(20, 17), ViewObject(ViewId::SWORD, ViewLayer::ITEM, "sword"));
+  CHECK(!memory.hasViewIndex(Vec2(4, 5)));
+  CHECK(!memory.hasViewIndex(Vec2(40, 29)));
+  CHECK(!memory.hasViewIndex(Vec2(6, 5)));
+  CHECKEQ(memory.getVersion(Vec2(300, 5)), 0);
+  std::stringstream stream;
+  {
+    boost::archive::binary_oarchive output(stream);
+    output << memory;
+  }
+  MapMemory loaded;
+  boost::archive::binary_iarchive input(stream);
+  input >> loaded;
+  for (Vec2 v : Rectangle(0, 0, 50, 50))
+    CHECKEQ(loaded.hasViewIndex(v), memory.hasViewIndex(v));
+  CHECK(loaded.getViewIndex(Vec2(39, 29)).hasObject(ViewLayer::FLOOR));
+  CHECK(loaded.getViewIndex(Vec2(20, 17)).hasObject(ViewLayer::ITEM));
+  loaded.update(Vec2(20, 17), floor);
+  CHECK(&loaded.getViewIndex(Vec2(20, 17)) == &loaded.getViewIndex(Vec2(5, 5)));
+}
+
+void testRenderThread() {
+  // the same protocol as WindowView: the view is only written after wait(), the frame only reads the view
+  Table<int> world(20, 20, 0);
+  Table<int> view(20, 20, 0);
+  vector<int> drawn;
+  bool consistent = true;
+  RenderThread renderThread;
+  for (int frame : Range(1, 100)) {
+    renderThread.wait();
+    for (Vec2 v : view.getBounds())
+      view[v] = world[v];
+    renderThread.draw([&] {
+      for (Vec2 v : view.getBounds())
+        if (view[v] != view[Vec2(0, 0)])
+          consistent = false;
+      drawn.push_back(view[Vec2(0, 0)]);
+    });
+    // the simulation carries on while the frame is being drawn
+    for (Vec2 v : world.getBounds())
+      world[v] = frame;
+  }
+  renderThread.wait();
+  CHECK(consistent);
+  CHECK(drawn.size() == 99);
+  for (int i : All(drawn))
+    CHECKEQ(drawn[i], i);
+  renderThread.draw([] { throw string("frame failed"); });
+  bool thrown = false;
+  try {
+    renderThread.wait();
+  } catch (string) {
+    thrown = true;
+  }
+  CHECK(thrown);
+  CHECK(!renderThread.isBusy());
+}
+
+void testMinimapTiles() {
+  // a fake level whose tiles get a new version whenever their color changes
+  Rectangle bounds(3, 2, 43, 32);
+  Table<int> color(bounds, 0);
+  Table<int> version(bounds, 0);
+  Table<bool> known(bounds, false);
+  // pixels are only redrawn when update() says so and only the dirty area is uploaded to the texture,
+  // yet the texture must match a full redraw
+  Table<int> buffer(bounds, -1);
+  Table<int> texture(bounds, -1);
+  MinimapTiles tiles;
+  tiles.reset(bounds);
+  int versionCounter = 0;
+  for (int turn : Range(100)) {
+    for (int i : Range(20)) {
+      Vec2 v = bounds.randomVec2();
+      color[v] = Random.getRandom(5);
+      version[v] = ++versionCounter;
+      known[v] = known[v] || Random.roll(2);
+    }
+    Vec2 center = bounds.randomVec2();
+    Rectangle part = Rectangle(center - Vec2(10, 10), center + Vec2(10, 10)).intersection(bounds);
+    for (Vec2 v : part)
+      if (tiles.update(v, known[v] ? version[v] : MinimapTiles::unknown))
+        buffer[v] = known[v] ? color[v] : -1;
+    if (auto area = tiles.popDirtyArea()) {
+      CHECK(bounds.contains(*area));
+      for (Vec2 v : *area)
+        texture[v] = buffer[v];
+    }
+    for (Vec2 v : part)
+      CHECKEQ(texture[v], known[v] ? color[v] : -1);
+  }
+  CHECK(!tiles.popDirtyArea());
+}
+
+void testFrameStats() {
+  FrameStats stats(4);
+  for (int i : Range(6)) {
+    stats.startFrame();
+    stats.add(FramePhase::MAP, i);
+    stats.add(FramePhase::GUI, 1);
+    stats.add(FramePhase::GUI, 1);
+  }
+  CHECKEQ(stats.getNumFrames(), 4);
+  for (int i : Range(4)) {
+    CHECKEQ(stats.getTime(i, FramePhase::MAP), i + 2);
+    CHECKEQ(stats.getTime(i, FramePhase::GUI), 2);
+    CHECKEQ(stats.getTime(i, FramePhase::FLIP), 0);
+    CHECKEQ(stats.getTotalTime(i), i + 4);
+  }
+  CHECKEQ(stats.getPercentile(FramePhase::MAP, 0), 2);
+  CHECKEQ(stats.getPercentile(FramePhase::MAP, 0.5), 4);
+  CHECKEQ(stats.getPercentile(FramePhase::MAP, 1), 5);
+  CHECKEQ(stats.getTotalPercentile(1), 7);
+  std::stringstream csv;
+  stats.printCsv(csv);
+  vector<string> lines = split(csv.str(), {'\n'});
+  CHECKEQ(int(lines.size()), 5);
+  CHECKEQ(lines[0], "frame,view_index,minimap,gui,map,flip,total");
+  CHECKEQ(lines[1], "0,0,0,2,2,0,4");
+  stats.clear();
+  CHECKEQ(stats.getNumFrames(), 0);
+  CHECKEQ(stats.getPercentile(FramePhase::MAP, 0.5), 0);
+}
+
+static string getLevelFingerprint(Level* level) {
+  string ret = level->getName();
+  for (Vec2 v : level->getBounds()) {
+    Square* square = level->getSquare(v);
+    ret += square->getName() + convertToString(int(square->getViewObject().id()));
+    for (Item* item : square->getItems())
+      ret += item->getName();
+  }
+  for (Creature* c : level->getAllCreatures())
+    ret += c->getName() + c->getFirstName().getOr("") + convertToString(c->getPosition());
+  return ret;
+}
+
+static vector<string> generateTestLevels(int numThreads) {
+  Random.init(5678);
+  Creature::initialize();
+  NameGenerator::init("first_names.txt", "aztec_names.txt", "creatures.txt",
+      "artifacts.txt", "world.txt", "town_names.txt", "dwarfs.txt", "gods.txt", "demons.txt", "dogs.txt",
+      "insults.txt");
+  Model model(nullptr);
+  WorldBuilder world;
+  for (int i : Range(3))
+    world.addLevel(Level::Builder(60, 35, "Mines " + convertToString(i)),
+        LevelMaker::roomLevel(CreatureFactory::level(i + 1), {StairKey::DWARF}, {StairKey::DWARF}));
+  world.addLevel(Level::Builder(30, 20, "Crypt"),
+      LevelMaker::cryptLevel(CreatureFactory::crypt(), {StairKey::CRYPT}, {}));
+  world.addLevel(Level::Builder(40, 30, "Cave"),
+      LevelMaker::cavernLevel(CreatureFactory::singleType(Tribe::get(TribeId::DRAGON), CreatureId::RED_DRAGON),
+          SquareType::MUD_WALL, SquareType::MUD, StairLook::NORMAL, {StairKey::DRAGON}, {}));
+  vector<PLevel> levels = world.build(&model, numThreads);
+  vector<string> ret;
+  for (PLevel& level : levels)
+    ret.push_back(getLevelFingerprint(level.get()));
+  return ret;
+}
+
+void testWorldBuilder() {
+  Random.init(1);
+  NameGenerator::init("first_names.txt", "aztec_names.txt", "creatures.txt",
+      "artifacts.txt", "world.txt", "town_names.txt", "dwarfs.txt", "gods.txt", "demons.txt", "dogs.txt",
+      "insults.txt");
+  ItemFactory::init();
+  Item::identifyEverything();
+  Tribe::init();
+  Skill::init();
+  Technology::init();
+  Vision::init();
+  // The pantheon is generated from Random when it's first needed, so it mustn't happen in only one of the runs.
+  Deity::getDeities();
+  vector<string> oneThread = generateTestLevels(1);
+  vector<string> manyThreads = generateTestLevels(4);
+  CHECKEQ(int(oneThread.size()), 5);
+  CHECKEQ(int(manyThreads.size()), 5);
+  for (int i : All(oneThread))
+    CHECK(oneThread[i] == manyThreads[i]) << "Level " << i << " depends on the number of threads";
+  // The default creatures are members of the monster tribe, so release them while it still exists.
+  Creature::initialize();
+}
+
+void testLevelBuilder() {
+  Level::Builder builder(10, 10, "Test");
+  for (Vec2 v : Rectangle(10, 10))
+    builder.putSquare(v, SquareType::GRASS);
+  builder.pushMap(Rectangle(2, 3, 7, 6), Level::Builder::CW1);
+  builder.putSquare(Vec2(2, 4), SquareType::ROCK_WALL, SquareAttrib::NO_DIG);
+  builder.addAttrib(Vec2(2, 4), SquareAttrib::MOUNTAIN);
+  builder.popMap();
+  CHECK(builder.getType(Vec2(3, 3)) == SquareType::ROCK_WALL);
+  CHECK(builder.hasAttrib(Vec2(3, 3), SquareAttrib::NO_DIG));
+  CHECK(builder.hasAttrib(Vec2(3, 3), SquareAttrib::MOUNTAIN));
+  builder.removeAttrib(Vec2(3, 3), SquareAttrib::MOUNTAIN);
+  CHECK(!builder.hasAttrib(Vec2(3, 3), SquareAttrib::MOUNTAIN));
+  CHECK(!builder.hasAttrib(Vec2(2, 4), SquareAttrib::NO_DIG));
+  CHECK(!builder.canEnter(Vec2(3, 3), Creature::getDefault()));
+  CHECK(builder.canEnter(Vec2(2, 4), Creature::getDefault()));
+  Model model(nullptr);
+  PLevel level = builder.build(&model);
+  CHECK(level->getSquare(Vec2(3, 3))->getName() == "wall");
+  CHECK(level->getSquare(Vec2(3, 3))->getBackgroundObject()->id() == ViewId::GRASS);
+  CHECK(!level->getSquare(Vec2(2, 4))->getBackgroundObject());
+  Creature::initialize();
+}
+
+void testSquarePrototypes() {
+  PSquare floor1 = SquareFactory::get(SquareType::FLOOR);
+  PSquare floor2 = SquareFactory::get(SquareType::FLOOR);
+  PSquare wall = SquareFactory::get(SquareType::ROCK_WALL);
+  CHECK(floor1->getTravelDir().empty());
+  CHECK(!floor1->getLandingLink());
+  CHECK(!floor1->isBurning());
+  floor1->addTravelDir(Vec2(1, 0));
+  floor1->addTravelDir(Vec2(1, 0));
+  floor1->setLandingLink(StairDirection::UP, StairKey::DWARF);
+  floor2->setName("stone floor");
+  CHECK(floor1->getTravelDir() == vector<Vec2>({Vec2(1, 0)}));
+  CHECK(floor1->isLandingSquare(StairDirection::UP, StairKey::DWARF));
+  CHECK(floor2->getTravelDir().empty());
+  CHECK(!floor2->isLandingSquare(StairDirection::UP, StairKey::DWARF));
+  CHECK(floor1->getName() == "floor");
+  CHECK(floor2->getName() == "stone floor");
+  CHECK(SquareFactory::get(SquareType::FLOOR)->getName() == "floor");
+  CHECK(floor2->canConstruct(SquareType::BED));
+  CHECK(!wall->canSeeThru());
+  wall->setVision(Vision::get(VisionId::NORMAL));
+  CHECK(wall->canSeeThru());
+  CHECK(!SquareFactory::get(SquareType::ROCK_WALL)->canSeeThru());
+  CHECKEQ(wall->getStrength(), 299);
+  CHECK(!wall->construct(SquareType::FLOOR));
+}
+
+void testLightMap() {
+  Rectangle bounds(40, 40);
+  Table<PSquare> squares(bounds);
+  for (Vec2 v : bounds)
+    squares[v] = SquareFactory::get(
+        v.inRectangle(bounds.minusMargin(1)) && (v.x % 7 != 3 || v.y % 5 == 0)
+        ? SquareType::FLOOR : SquareType::ROCK_WALL);
+  LightMap lightMap(squares);
+  auto replace = [&](Vec2 pos, SquareType type) {
+    squares[pos] = SquareFactory::get(type);
+    lightMap.setSource(pos, squares[pos]->getLightEmission());
+    lightMap.squareChanged(pos);
+  };
+  auto check = [&] {
+    lightMap.update();
+    Table<double> expected(bounds, 0);
+    FieldOfView fov(squares, Vision::get(VisionId::NORMAL));
+    for (Vec2 pos : bounds)
+      if (double radius = squares[pos]->getLightEmission())
+        for (Vec2 v : fov.getVisibleTiles(pos)) {
+          double dist = (v - pos).lengthD();
+          if (dist <= radius)
+            expected[v] += min(1.0, 1 - dist / radius);
+        }
+    for (Vec2 v : bounds)
+      CHECK(fabs(expected[v] - lightMap.getLight(v)) < 0.000001) << v << " " << expected[v] << " "
+          << lightMap.getLight(v);
+  };
+  for (Vec2 v : {Vec2(5, 5), Vec2(12, 20), Vec2(20, 21), Vec2(30, 8)})
+    replace(v, SquareType::TORCH);
+  check();
+  for (Vec2 v : {Vec2(10, 3), Vec2(14, 19), Vec2(6, 6), Vec2(20, 25)})
+    replace(v, SquareType::ROCK_WALL);
+  check();
+  for (Vec2 v : {Vec2(10, 3), Vec2(17, 6), Vec2(17, 7), Vec2(24, 21), Vec2(14, 19)})
+    replace(v, SquareType::FLOOR);
+  check();
+  replace(Vec2(5, 5), SquareType::FLOOR);
+  replace(Vec2(21, 20), SquareType::TORCH);
+  check();
+}
+
+void testPoisonGas() {
+  Rectangle bounds(30, 30);
+  auto canSpread = [](Vec2 v) { return v.x != 20; };
+  PoisonGas gas(bounds);
+  gas.addAmount(Vec2(10, 10), 2);
+  gas.addAmount(Vec2(10, 10), 2);
+  CHECKEQ(gas.getAmount(Vec2(10, 10)), 3);
+  CHECKEQ(gas.getNumActive(), 1);
+  CHECKEQ((int) gas.tick(canSpread).size(), 9);
+  CHECK(fabs(gas.getAmount(Vec2(10, 10)) - 2.399) < 0.0001);
+  CHECK(fabs(gas.getAmount(Vec2(11, 10)) - 0.1) < 0.0001);
+  CHECK(fabs(gas.getAmount(Vec2(11, 11)) - 0.05) < 0.0001);
+  for (int i : Range(30)) {
+    gas.tick(canSpread);
+    for (Vec2 v : {Vec2(9, 10), Vec2(10, 9), Vec2(10, 11)})
+      CHECK(fabs(gas.getAmount(v) - gas.getAmount(Vec2(11, 10))) < 0.0001);
+    for (int y : Range(30))
+      CHECKEQ(gas.getAmount(Vec2(20, y)), 0);
+  }
+  PoisonGas gas2(bounds);
+  gas2.addAmount(Vec2(10, 10), 3);
+  for (int i : Range(31))
+    gas2.tick(canSpread);
+  for (Vec2 v : bounds)
+    CHECKEQ(gas.getAmount(v), gas2.getAmount(v));
+  for (int i : Range(1000))
+    gas.tick(canSpread);
+  CHECKEQ(gas.getNumActive(), 0);
+  for (Vec2 v : bounds)
+    CHECKEQ(gas.getAmount(v), 0);
+}
+
+void testTickingSquares() {
+  Level::Builder builder(10, 10, "Test");
+  for (Vec2 v : Rectangle(10, 10))
+    builder.putSquare(v, v.inRectangle(Rectangle(1, 1, 9, 9)) ? SquareType::FLOOR : SquareType::ROCK_WALL);
+  Model model(nullptr);
+  PLevel level = builder.build(&model);
+  CHECKEQ(level->getNumTickingSquares(), 0);
+  for (Vec2 v : {Vec2(1, 1), Vec2(2, 2), Vec2(3, 3)})
+    level->getSquare(v)->dropItem(ItemFactory::fromId(ItemId::ROCK));
+  level->getSquare(Vec2(2, 2))->dropItem(ItemFactory::fromId(ItemId::ROCK));
+  CHECKEQ(level->getNumTickingSquares(), 3);
+  level->tick(1);
+  CHECKEQ(level->getNumTickingSquares(), 3);
+  Square* square = level->getSquare(Vec2(1, 1));
+  square->removeItems(square->getItems());
+  level->tick(2);
+  CHECKEQ(level->getNumTickingSquares(), 2);
+  level->replaceSquare(Vec2(2, 2), SquareFactory::get(SquareType::FLOOR));
+  CHECKEQ((int) level->getSquare(Vec2(2, 2))->getItems().size(), 2);
+  CHECKEQ(level->getNumTickingSquares(), 2);
+  square = level->getSquare(Vec2(2, 2));
+  square->removeItems(square->getItems());
+  CHECK(!square->needsTicking());
+  level->tick(3);
+  CHECKEQ(level->getNumTickingSquares(), 1);
+  CHECK(level->getSquare(Vec2(3, 3))->needsTicking());
+  CHECK(SquareFactory::get(SquareType::HATCHERY)->needsTicking());
+}
+
 void testRange() {
   vector<int> a;
   vector<int> b {0,1,2,3,4,5,6};
@@ -386,6 +927,85 @@ void testSectors2() {
   CHECK(!s.same(Vec2(0, 3), Vec2(3, 2)));
 }
 
+static Table<int> getSectorsBruteForce(const Table<bool>& open) {
+  Table<int> ret(open.getBounds(), -1);
+  int numSectors = 0;
+  for (Vec2 v : open.getBounds())
+    if (open[v] && ret[v] == -1) {
+      queue<Vec2> q;
+      q.push(v);
+      ret[v] = numSectors;
+      while (!q.empty()) {
+        Vec2 pos = q.front();
+        q.pop();
+        for (Vec2 w : pos.neighbors8())
+          if (w.inRectangle(open.getBounds()) && open[w] && ret[w] == -1) {
+            ret[w] = numSectors;
+            q.push(w);
+          }
+      }
+      ++numSectors;
+    }
+  return ret;
+}
+
+void testSectors3() {
+  Rectangle bounds(20, 20);
+  Sectors s(bounds);
+  Table<bool> open(bounds, false);
+  Random.init(1234);
+  for (int i : Range(2000)) {
+    Vec2 pos = bounds.randomVec2();
+    if (Random.roll(3)) {
+      s.remove(pos);
+      open[pos] = false;
+    } else {
+      s.add(pos);
+      open[pos] = true;
+    }
+    if (i % 50 == 0) {
+      Table<int> expected = getSectorsBruteForce(open);
+      for (Vec2 v : bounds)
+        for (Vec2 w : Rectangle(v - Vec2(3, 3), v + Vec2(4, 4)).intersection(bounds))
+          CHECK(s.same(v, w) == (expected[v] > -1 && expected[v] == expected[w])) << v << " " << w;
+    }
+  }
+}
+
+void testSectorsDigging() {
+  // imps digging tunnels into a mountain, with an occasional door or collapsed tunnel
+  Rectangle bounds(250, 250);
+  Sectors s(bounds);
+  Table<bool> open(bounds, false);
+  Random.init(4321);
+  vector<Vec2> diggers;
+  for (int i : Range(20))
+    diggers.push_back(bounds.middle());
+  s.add(bounds.middle());
+  open[bounds.middle()] = true;
+  MEASURE({
+    for (int i : Range(50000)) {
+      Vec2& pos = diggers[i % diggers.size()];
+      Vec2 next = pos + Vec2::directions4()[Random.getRandom(4)];
+      if (next.inRectangle(bounds.minusMargin(1))) {
+        pos = next;
+        s.add(pos);
+        open[pos] = true;
+      }
+      if (Random.roll(50)) {
+        s.remove(pos);
+        open[pos] = false;
+      }
+    }
+  }, "Sectors digging time");
+  Table<int> expected = getSectorsBruteForce(open);
+  for (int i : Range(10000)) {
+    Vec2 v = bounds.randomVec2();
+    Vec2 w = bounds.randomVec2();
+    CHECK(s.same(v, w) == (expected[v] > -1 && expected[v] == expected[w])) << v << " " << w;
+  }
+}
+
 void testReverse() {
   vector<int> v1 {1, 2, 3, 4};
   vector<int> v2 {4, 3, 2, 1};
@@ -416,6 +1036,22 @@ int testAll() {
   testShortestPath2();
   testShortestPathReverse();
   testRandom();
+  testRandomStreams();
+  testMarkovChain();
+  testSpriteBatchOrder();
+  testSpriteBatchMap();
+  testViewIndex();
+  testMapMemory();
+  testMapMemoryBounds();
+  testRenderThread();
+  testMinimapTiles();
+  testFrameStats();
+  testWorldBuilder();
+  testLevelBuilder();
+  testSquarePrototypes();
+  testLightMap();
+  testPoisonGas();
+  testTickingSquares();
   testRange();
   testContains();
   testPredicates();
@@ -434,6 +1070,8 @@ int testAll() {
   testVec2Box2();
   testSectors1();
   testSectors2();
+  testSectors3();
+  testSectorsDigging();
   testReverse();
   testReverse2();
   testReverse3();
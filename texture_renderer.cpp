@@ -22,10 +22,12 @@ void TextureRenderer::initialize(int width, int height) {
 }
 
 const Texture& TextureRenderer::getTexture() {
+  flush();
   tex.display();
   return tex.getTexture();
 }
 
 void TextureRenderer::clear() {
+  flush();
   tex.clear(Color(0, 0, 0, 0));
 }
@@ -19,8 +19,7 @@
 using namespace colors;
 
 Tile getSpecialCreature(const ViewObject& obj, bool humanoid) {
-  RandomGen r;
-  r.init(hash<string>()(obj.getBareDescription()));
+  RandomGen r = RandomGen().getStream(obj.getBareDescription());
   string let = humanoid ? "WETUIPLKJHFAXBM" : "qwetyupkfaxbnm";
   char c;
   if (contains(let, obj.getBareDescription()[0]))
@@ -35,8 +34,7 @@ Tile getSpecialCreature(const ViewObject& obj, bool humanoid) {
 }
 
 Tile getSpecialCreatureSprite(const ViewObject& obj, bool humanoid) {
-  RandomGen r;
-  r.init(hash<string>()(obj.getBareDescription()));
+  RandomGen r = RandomGen().getStream(obj.getBareDescription());
   if (humanoid)
     return Tile(r.getRandom(7), 10);
   else
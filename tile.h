@@ -34,8 +34,18 @@ class Tile {
   Tile(int x, int y, int num = 0, bool _stickingOut = false) : stickingOut(_stickingOut),tileCoord(Vec2(x, y)), 
       texNum(num) {}
 
+  /** Returns the bit that represents a cardinal direction in connection masks.*/
+  static int getConnectionBit(Dir dir) {
+    CHECK(contains({Dir::N, Dir::S, Dir::E, Dir::W}, dir));
+    return 1 << int(dir);
+  }
+
   Tile& addConnection(set<Dir> c, int x, int y) {
-    connections.insert({c, Vec2(x, y)});
+    int mask = 0;
+    for (Dir dir : c)
+      mask |= getConnectionBit(dir);
+    connections[mask] = Vec2(x, y);
+    connectionSet |= 1 << mask;
     return *this;
   }
 
@@ -52,9 +62,10 @@ class Tile {
     return *tileCoord;
   }
 
-  Vec2 getSpriteCoord(set<Dir> c) {
-    if (connections.count(c))
-      return connections.at(c);
+  /** Returns the sprite for a tile that connects to its neighbours in the directions given by the mask.*/
+  Vec2 getSpriteCoord(int connectionMask) {
+    if (connectionSet & (1 << connectionMask))
+      return connections[connectionMask];
     else return *tileCoord;
   }
 
@@ -66,7 +77,8 @@ class Tile {
   private:
   Optional<Vec2> tileCoord;
   int texNum = 0;
-  unordered_map<set<Dir>, Vec2> connections;
+  Vec2 connections[16];
+  unsigned short connectionSet = 0;
 };
 
 
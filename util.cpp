@@ -18,17 +18,64 @@
 #include "util.h"
 
 
+// The finalizer of SplitMix64. Consecutive counters give independent looking numbers.
+static uint64_t mix(uint64_t z) {
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+// FNV-1a, unlike std::hash it's the same on every platform.
+static uint64_t hashName(const string& name) {
+  uint64_t ret = 0xcbf29ce484222325ULL;
+  for (char c : name)
+    ret = (ret ^ (unsigned char) c) * 0x100000001b3ULL;
+  return ret;
+}
+
+RandomGen::RandomGen() : RandomGen(mix(0)) {
+}
+
+RandomGen::RandomGen(uint64_t k) : key(k) {
+}
+
 void RandomGen::init(int seed) {
-  generator.seed(seed);
+  key = mix(uint64_t(seed));
+  counter = 0;
+  shuffleMap.clear();
+}
+
+uint64_t RandomGen::next() {
+  return mix(key + (++counter) * 0x9e3779b97f4a7c15ULL);
+}
+
+RandomGen RandomGen::split() {
+  return RandomGen(mix(next() ^ key));
+}
+
+RandomGen RandomGen::getStream(const string& name) const {
+  return RandomGen(mix(key ^ hashName(name)));
+}
+
+RandomGen RandomGen::getStream(int id) const {
+  return RandomGen(mix(key ^ mix(uint64_t(id) + 0x632be59bd9b4e019ULL)));
 }
 
 int RandomGen::getRandom(int max) {
   return getRandom(0, max);
 }
 
+// Maps a 32-bit number to the range with a multiplication, rejecting the few numbers that would make it biased.
 int RandomGen::getRandom(int min, int max) {
   CHECK(max > min);
-  return uniform_int_distribution<int>(min, max - 1)(generator);
+  uint64_t range = uint64_t((long long) max - min);
+  uint64_t m = (next() >> 32) * range;
+  if ((m & 0xffffffffULL) < range) {
+    uint64_t threshold = ((1ULL << 32) - range) % range;
+    while ((m & 0xffffffffULL) < threshold)
+      m = (next() >> 32) * range;
+  }
+  return int((long long) min + (long long) (m >> 32));
 }
 
 void RandomGen::makeShuffle(string id, int min, int max) {
@@ -38,7 +85,7 @@ void RandomGen::makeShuffle(string id, int min, int max) {
   info.maxRange = max;
   for (int i : Range(min, max))
     info.numbers.push_back(i);
-  random_shuffle(info.numbers.begin(), info.numbers.end(), [](int a) { return Random.getRandom(a);});
+  random_shuffle(info.numbers.begin(), info.numbers.end(), [this](int a) { return getRandom(a);});
   shuffleMap.insert({id, std::move(info)});
 }
 
@@ -76,7 +123,7 @@ int RandomGen::getRandom(const vector<double>& weights, double r) {
   for (double elem : weights)
     sum += elem;
   if (r == -1)
-    r = Random.getDouble(0, sum);
+    r = getDouble(0, sum);
   sum = 0;
   for (int i : All(weights)) {
     sum += weights[i];
@@ -91,14 +138,30 @@ bool RandomGen::roll(int chance) {
 }
 
 double RandomGen::getDouble() {
-  return defaultDist(generator);
+  return double(next() >> 11) / double(1ULL << 53);
 }
 
 double RandomGen::getDouble(double a, double b) {
-  return uniform_real_distribution<double>(a, b)(generator);
+  return a + (b - a) * getDouble();
+}
+
+template <class Archive> 
+void RandomGen::ShuffleInfo::serialize(Archive& ar, const unsigned int version) {
+  ar & BOOST_SERIALIZATION_NVP(minRange)
+    & BOOST_SERIALIZATION_NVP(maxRange)
+    & BOOST_SERIALIZATION_NVP(numbers);
 }
 
-RandomGen Random;
+template <class Archive> 
+void RandomGen::serialize(Archive& ar, const unsigned int version) {
+  ar & BOOST_SERIALIZATION_NVP(key)
+    & BOOST_SERIALIZATION_NVP(counter)
+    & BOOST_SERIALIZATION_NVP(shuffleMap);
+}
+
+SERIALIZABLE(RandomGen);
+
+thread_local RandomGen Random;
 
 template string convertToString<int>(const int&);
 template string convertToString<size_t>(const size_t&);
@@ -503,6 +566,10 @@ bool Rectangle::intersects(const Rectangle& other) const {
   return max(px, other.px) < min(kx, other.kx) && max(py, other.py) < min(ky, other.ky);
 }
 
+bool Rectangle::operator == (const Rectangle& other) const {
+  return px == other.px && py == other.py && kx == other.kx && ky == other.ky;
+}
+
 bool Rectangle::contains(const Rectangle& other) const {
   return px <= other.px && py <= other.py && kx >= other.kx && ky >= other.ky;
 }
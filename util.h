@@ -202,6 +202,7 @@ class Rectangle {
 
   bool intersects(const Rectangle& other) const;
   bool contains(const Rectangle& other) const;
+  bool operator == (const Rectangle& other) const;
   Rectangle intersection(const Rectangle& other) const;
 
   Rectangle minusMargin(int margin) const;
@@ -273,8 +274,13 @@ extern const vector<Vec2> neighbors;
 
 #define GET_ID(uniqueId) (string(__FILE__) + convertToString(__LINE__) + convertToString(uniqueId))
 
+/**
+  * Counter based random generator. A stream is a 64-bit key, and the n-th number is a hash of the key and n,
+  * so streams are cheap to copy, split and serialize, and numbers are the same on every platform.
+  */
 class RandomGen {
   public:
+  RandomGen();
   void init(int seed);
   int getRandom(int max);
   int getRandom(int min, int max);
@@ -284,19 +290,36 @@ class RandomGen {
   double getDouble(double a, double b);
   bool roll(int chance);
 
+  /** Returns a new independent stream, advancing this one by a single number.*/
+  RandomGen split();
+
+  /** Returns a named sub-stream. It only depends on the seed of this stream and the name, not on how
+      many numbers were drawn from it.*/
+  RandomGen getStream(const string& name) const;
+  RandomGen getStream(int id) const;
+
+  template <class Archive> 
+  void serialize(Archive& ar, const unsigned int version);
+
   private:
+  explicit RandomGen(uint64_t key);
+  uint64_t next();
   void makeShuffle(string id, int min, int max);
-  default_random_engine generator;
-  std::uniform_real_distribution<double> defaultDist;
+  uint64_t key;
+  uint64_t counter = 0;
   struct ShuffleInfo {
     int minRange;
     int maxRange;
     vector<int> numbers;
+
+    template <class Archive> 
+    void serialize(Archive& ar, const unsigned int version);
   };
   unordered_map<string, ShuffleInfo> shuffleMap;
 };
 
-extern RandomGen Random;
+// Every thread has its own generator, so that levels can be generated in parallel.
+extern thread_local RandomGen Random;
 
 inline Debug& operator <<(Debug& d, Rectangle rect) {
   return d << "(" << rect.getPX() << "," << rect.getPY() << ") (" << rect.getKX() << "," << rect.getKY() << ")";
@@ -980,6 +1003,13 @@ class EnumSet : public EnumMap<T, bool> {
     (*this)[elem] = true;
   }
 
+  bool isEmpty() const {
+    for (int i = 0; i < int(T::ENUM_END); ++i)
+      if ((*this)[T(i)])
+        return false;
+    return true;
+  }
+
   class Iter {
     public:
     Iter(const EnumSet& s, int num) : set(s), ind(num) {
@@ -46,6 +46,6 @@ void View::setJukebox(Jukebox* j) {
 }
 
 Jukebox* View::getJukebox() {
-  return NOTNULL(jukebox);
+  return jukebox;
 }
 
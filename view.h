@@ -151,6 +151,8 @@ class View {
   virtual bool isClockStopped() = 0;
 
   void setJukebox(Jukebox*);
+
+  /** Returns null if the view doesn't play music.*/
   Jukebox* getJukebox();
 
   /** Returns a default View that additionally logs all player actions into a file.*/
@@ -20,58 +20,44 @@
 
 template <class Archive> 
 void ViewIndex::serialize(Archive& ar, const unsigned int version) {
-  ar& SVAR(objIndex)
-    & SVAR(objects)
-    & SVAR(highlight);
+  ar& SVAR(layers);
+  for (ViewLayer layer : layers)
+    ar & boost::serialization::make_nvp("object", objects[int(layer)]);
+  ar& SVAR(highlights)
+    & SVAR(highlightAmount);
   CHECK_SERIAL;
 }
 
 SERIALIZABLE(ViewIndex);
 
-
-template <class Archive> 
-void ViewIndex::HighlightInfo::serialize(Archive& ar, const unsigned int version) {
-  ar& BOOST_SERIALIZATION_NVP(type)
-    & BOOST_SERIALIZATION_NVP(amount);
-}
-
-SERIALIZABLE(ViewIndex::HighlightInfo);
-
 ViewIndex::ViewIndex() {
-  objIndex = vector<int>(allLayers.size(), -1);
 }
+
 void ViewIndex::insert(const ViewObject& obj) {
-  int ind = objIndex[int(obj.layer())];
-  if (ind > -1)
-    objects[ind] = obj;
-  else {
-    objIndex[int(obj.layer())] = objects.size();
-    objects.push_back(obj);
-  }
+  layers.insert(obj.layer());
+  objects[int(obj.layer())] = obj;
 }
 
 bool ViewIndex::hasObject(ViewLayer l) const {
-  return objIndex[int(l)] > -1;
+  return layers[l];
 }
 
 void ViewIndex::removeObject(ViewLayer l) {
-  objIndex[int(l)] = -1;
+  layers[l] = false;
 }
 
 bool ViewIndex::isEmpty() const {
-  return objects.empty() && highlight.empty();
+  return layers.isEmpty() && highlights.isEmpty();
 }
 
 const ViewObject& ViewIndex::getObject(ViewLayer l) const {
-  int ind = objIndex[int(l)];
-  CHECK(ind > -1) << "No object on layer " << int(l);
-  return objects[ind];
+  CHECK(layers[l]) << "No object on layer " << int(l);
+  return objects[int(l)];
 }
 
 ViewObject& ViewIndex::getObject(ViewLayer l) {
-  int ind = objIndex[int(l)];
-  CHECK(ind > -1) << "No object on layer " << int(l);
-  return objects[ind];
+  CHECK(layers[l]) << "No object on layer " << int(l);
+  return objects[int(l)];
 }
 
 Optional<ViewObject> ViewIndex::getTopObject(const vector<ViewLayer>& layers) const {
@@ -87,15 +73,35 @@ void ViewIndex::addHighlight(HighlightInfo info) {
 
 void ViewIndex::addHighlight(HighlightType h, double amount) {
   CHECK(amount >= 0 && amount <= 1);
-  for (auto& elem : highlight)
-    if (elem.type == h) {
-      elem.amount = max(elem.amount, amount);
-      return;
-    }
-  highlight.push_back({h, amount});
+  if (!highlights[h] || highlightAmount[h] < amount)
+    highlightAmount[h] = amount;
+  highlights.insert(h);
 }
 
-vector<ViewIndex::HighlightInfo> ViewIndex::getHighlight() const {
-  return highlight;
+bool ViewIndex::hasHighlight(HighlightType h) const {
+  return highlights[h];
 }
 
+double ViewIndex::getHighlight(HighlightType h) const {
+  CHECK(highlights[h]);
+  return highlightAmount[h];
+}
+
+bool ViewIndex::operator == (const ViewIndex& o) const {
+  for (ViewLayer l : ENUM_ALL(ViewLayer))
+    if (layers[l] != o.layers[l] || (layers[l] && !(objects[int(l)] == o.objects[int(l)])))
+      return false;
+  for (HighlightType h : ENUM_ALL(HighlightType))
+    if (highlights[h] != o.highlights[h] || (highlights[h] && highlightAmount[h] != o.highlightAmount[h]))
+      return false;
+  return true;
+}
+
+size_t ViewIndex::getHash() const {
+  size_t ret = 0;
+  for (ViewLayer l : layers)
+    ret = ret * 31 + objects[int(l)].getHash();
+  for (HighlightType h : highlights)
+    ret = ret * 31 + size_t(h) * 7 + hash<float>()(highlightAmount[h]);
+  return ret;
+}
@@ -32,24 +32,33 @@ class ViewIndex {
   struct HighlightInfo {
     HighlightType type;
     double amount;
-
-    template <class Archive> 
-    void serialize(Archive& ar, const unsigned int version);
   };
 
   void addHighlight(HighlightType, double amount = 1);
   void addHighlight(HighlightInfo);
+  bool hasHighlight(HighlightType) const;
+  double getHighlight(HighlightType) const;
 
-  vector<HighlightInfo> getHighlight() const;
+  bool operator == (const ViewIndex&) const;
+  size_t getHash() const;
 
   template <class Archive> 
   void serialize(Archive& ar, const unsigned int version);
 
   SERIAL_CHECKER;
   private:
-  vector<int> SERIAL(objIndex);
-  vector<ViewObject> SERIAL(objects);
-  vector<HighlightInfo> SERIAL(highlight);
+  EnumSet<ViewLayer> SERIAL(layers);
+  ViewObject objects[int(ViewLayer::ENUM_END)];
+  EnumSet<HighlightType> SERIAL(highlights);
+  EnumMap<HighlightType, float> SERIAL(highlightAmount);
+};
+
+namespace std {
+template <> struct hash<ViewIndex> {
+  size_t operator()(const ViewIndex& index) const {
+    return index.getHash();
+  }
 };
+}
 
 #endif
@@ -17,13 +17,36 @@
 
 #include "view_object.h"
 
+static deque<string>& getDescriptions() {
+  static deque<string> descriptions {""};
+  return descriptions;
+}
+
+// descriptions are interned by the game thread while the render thread reads them
+static std::mutex descriptionMutex;
+
+static int getDescriptionId(const string& description) {
+  static unordered_map<string, int> ids {{"", 0}};
+  std::unique_lock<std::mutex> lock(descriptionMutex);
+  auto it = ids.find(description);
+  if (it != ids.end())
+    return it->second;
+  int ret = getDescriptions().size();
+  getDescriptions().push_back(description);
+  ids.insert(make_pair(description, ret));
+  return ret;
+}
+
 template <class Archive> 
 void ViewObject::serialize(Archive& ar, const unsigned int version) {
+  string descriptionText;
+  if (Archive::is_saving::value)
+    descriptionText = getBareDescription();
   ar& SVAR(bleeding)
     & SVAR(enemyStatus)
     & SVAR(resource_id)
     & SVAR(viewLayer)
-    & SVAR(description)
+    & boost::serialization::make_nvp("description", descriptionText)
     & SVAR(burning)
     & SVAR(height)
     & SVAR(modifiers)
@@ -31,31 +54,33 @@ void ViewObject::serialize(Archive& ar, const unsigned int version) {
     & SVAR(defense)
     & SVAR(level)
     & SVAR(waterDepth);
+  if (Archive::is_loading::value)
+    description = getDescriptionId(descriptionText);
   CHECK_SERIAL;
 }
 
 SERIALIZABLE(ViewObject);
 
 ViewObject::ViewObject(ViewId id, ViewLayer l, const string& d)
-    : resource_id(id), viewLayer(l), description(d) {
-  if (islower(description[0]))
-    description[0] = toupper(description[0]);
-  for (int i : Range(numModifiers))
-    modifiers[i] = false;
+    : resource_id(id), viewLayer(l) {
+  if (!d.empty() && islower(d[0]))
+    description = getDescriptionId(char(toupper(d[0])) + d.substr(1));
+  else
+    description = getDescriptionId(d);
 }
 
 ViewObject& ViewObject::setModifier(Modifier mod) {
-  modifiers[int(mod)] = true;
+  modifiers |= (1 << int(mod));
   return *this;
 }
 
 ViewObject& ViewObject::removeModifier(Modifier mod) {
-  modifiers[int(mod)] = false;
+  modifiers &= ~(1 << int(mod));
   return *this;
 }
 
 bool ViewObject::hasModifier(Modifier mod) const {
-  return modifiers[int(mod)];
+  return modifiers & (1 << int(mod));
 }
 
 ViewObject& ViewObject::setWaterDepth(double depth) {
@@ -103,8 +128,10 @@ double ViewObject::getHeight() const {
   return height;
 }
 
-string ViewObject::getBareDescription() const {
-  return description;
+const string& ViewObject::getBareDescription() const {
+  // elements of a deque don't move when it grows, so the reference stays valid after unlocking
+  std::unique_lock<std::mutex> lock(descriptionMutex);
+  return getDescriptions()[description];
 }
 
 string ViewObject::getDescription(bool stats) const {
@@ -123,9 +150,9 @@ string ViewObject::getDescription(bool stats) const {
   if (hasModifier(PLANNED))
     mods.push_back("planned");
   if (mods.size() > 0)
-    return description + attr + "(" + combine(mods) + ")";
+    return getBareDescription() + attr + "(" + combine(mods) + ")";
   else
-    return description + attr;
+    return getBareDescription() + attr;
 }
 
 void ViewObject::setAttack(int val) {
@@ -140,6 +167,22 @@ void ViewObject::setLevel(int val) {
   level = val;
 }
 
+bool ViewObject::operator == (const ViewObject& o) const {
+  return resource_id == o.resource_id && viewLayer == o.viewLayer && description == o.description
+      && modifiers == o.modifiers && enemyStatus == o.enemyStatus && bleeding == o.bleeding
+      && burning == o.burning && height == o.height && attack == o.attack && defense == o.defense
+      && level == o.level && waterDepth == o.waterDepth;
+}
+
+size_t ViewObject::getHash() const {
+  size_t ret = size_t(resource_id);
+  for (size_t elem : {size_t(viewLayer), size_t(description), size_t(modifiers), size_t(enemyStatus),
+      hash<float>()(bleeding), hash<float>()(burning), hash<float>()(height), size_t(attack), size_t(defense),
+      size_t(level), hash<float>()(waterDepth)})
+    ret = ret * 31 + elem;
+  return ret;
+}
+
 ViewLayer ViewObject::layer() const {
   return viewLayer;
 }
@@ -56,7 +56,7 @@ class ViewObject {
   double getWaterDepth() const;
 
   string getDescription(bool stats = false) const;
-  string getBareDescription() const;
+  const string& getBareDescription() const;
 
   ViewLayer layer() const;
   ViewId id() const;
@@ -65,23 +65,29 @@ class ViewObject {
   const static ViewObject& empty();
   const static ViewObject& mana();
 
+  bool operator == (const ViewObject&) const;
+  size_t getHash() const;
+
   SERIALIZATION_DECL(ViewObject);
 
   private:
-  double SERIAL2(bleeding, 0);
+  friend class ViewIndex;
+  float SERIAL2(bleeding, 0);
   EnemyStatus SERIAL2(enemyStatus, UNKNOWN);
-  bool modifiers[numModifiers];
-  SERIAL3(modifiers);
-  ViewId SERIAL(resource_id);
-  ViewLayer SERIAL(viewLayer);
-  string SERIAL(description);
-  double SERIAL2(burning, false);
-  double SERIAL2(height, 0);
+  unsigned short SERIAL2(modifiers, 0);
+  ViewId SERIAL2(resource_id, ViewId::EMPTY);
+  ViewLayer SERIAL2(viewLayer, ViewLayer::FLOOR);
+  // Number of the description in a table shared by all objects, as the same few names are used all the time.
+  int SERIAL2(description, 0);
+  float SERIAL2(burning, 0);
+  float SERIAL2(height, 0);
   int SERIAL2(attack, -1);
   int SERIAL2(defense, -1);
   int SERIAL2(level, -1);
-  double SERIAL2(waterDepth, -1);
+  float SERIAL2(waterDepth, -1);
 };
 
+static_assert(ViewObject::numModifiers <= 16, "Modifiers don't fit in the mask");
+
 
 #endif
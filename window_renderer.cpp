@@ -19,10 +19,19 @@
 using namespace sf;
 
 void WindowRenderer::drawAndClearBuffer() {
+  flush();
   display->display();
   display->clear(Color(0, 0, 0));
 }
 
+void WindowRenderer::setActive(bool state) {
+  display->setActive(state);
+}
+
+void WindowRenderer::setVisible(bool state) {
+  display->setVisible(state);
+}
+
 void WindowRenderer::resize(int width, int height) {
   display->setView(*(sfView = new sf::View(sf::FloatRect(0, 0, width, height))));
 }
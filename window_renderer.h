@@ -34,6 +34,10 @@ class WindowRenderer : public Renderer {
   public: 
   void initialize(int width, int height, string title);
   void drawAndClearBuffer();
+  /** Makes the window's OpenGL context current in the calling thread, or releases it.
+    * It has to be released before another thread can draw to the window.*/
+  void setActive(bool);
+  void setVisible(bool);
   void resize(int width, int height);
   bool pollEvent(Event&, Event::EventType);
   bool pollEvent(Event&);
@@ -138,7 +138,7 @@ void WindowView::resetMapBounds() {
   minimapDecoration->setBounds(getMinimapBounds().minusMargin(-6));
 }
 
-WindowView::WindowView() : objects(Level::getMaxBounds()) {}
+WindowView::WindowView() : objects(Level::getMaxBounds()), tileCache(Level::getMaxBounds()) {}
 
 bool tilesOk = true;
 
@@ -207,10 +207,15 @@ void WindowView::initialize() {
 }
 
 void WindowView::reset() {
+  renderThread.wait();
   mapLayout = &currentTileLayout.normalLayout;
   center = {0, 0};
   gameReady = false;
   clearMessageBox();
+  for (Vec2 v : tileCache.getBounds())
+    tileCache[v] = Nothing();
+  minimapGui->clear();
+  clearGuiPanels();
 }
 
 static vector<Vec2> splashPositions;
@@ -282,6 +287,7 @@ void displayMenuSplash() {
 }
 
 void WindowView::displaySplash(View::SplashType type, bool& ready) {
+  renderThread.wait();
   string text;
   switch (type) {
     case View::CREATING: text = "Creating a new world, just for you..."; break;
@@ -318,13 +324,23 @@ struct KeyInfo {
   Event::KeyEvent event;
 };
 
+void WindowView::setWindowVisible(bool visible) {
+  renderThread.wait();
+  renderer.setVisible(visible);
+}
+
 void WindowView::close() {
+  renderThread.wait();
 }
 
 int fireVar = 50;
 
+// drawing happens on the render thread, so it must not touch the game's Random
+static RandomGen drawRandom;
+
 Color WindowView::getFireColor() {
-  return Color(200 + Random.getRandom(-fireVar, fireVar), Random.getRandom(fireVar), Random.getRandom(fireVar), 150);
+  return Color(200 + drawRandom.getRandom(-fireVar, fireVar), drawRandom.getRandom(fireVar),
+      drawRandom.getRandom(fireVar), 150);
 }
 
 void printStanding(int x, int y, double standing, const string& tribeName) {
@@ -346,16 +362,17 @@ PGuiElem WindowView::getSunlightInfoGui(GameInfo::SunlightInfo& sunlightInfo) {
   vector<PGuiElem> line;
   Color color = sunlightInfo.description == "day" ? white : lightBlue;
   line.push_back(GuiElem::label(sunlightInfo.description, color));
-  line.push_back(GuiElem::label("[" + convertToString(sunlightInfo.timeRemaining) + "]", color));
+  line.push_back(GuiElem::variableLabel([&sunlightInfo] {
+        return "[" + convertToString(sunlightInfo.timeRemaining) + "]"; }, color));
   return GuiElem::stack(
     mapGui->getHintCallback(sunlightInfo.description == "day"
       ? "Time remaining till nightfall." : "Time remaining till day."),
     GuiElem::horizontalList(std::move(line), renderer.getTextLength(sunlightInfo.description) + 5, 0));
 }
 
-PGuiElem WindowView::getTurnInfoGui(int turn) {
+PGuiElem WindowView::getTurnInfoGui(const double& turn) {
   return GuiElem::stack(mapGui->getHintCallback("Current turn"),
-      GuiElem::label("T: " + convertToString(turn), white));
+      GuiElem::variableLabel([&turn] { return "T: " + convertToString(int(turn)); }, white));
 }
 
 PGuiElem WindowView::drawBottomPlayerInfo(GameInfo::PlayerInfo& info, GameInfo::SunlightInfo& sunlightInfo) {
@@ -780,49 +797,160 @@ const int minionWindowRightMargin = 20;
 const int minionWindowWidth = 340;
 const int minionWindowHeight = 600;
 
+/** Collects everything that a GUI panel is drawn from, so that the panel is rebuilt only when it changes.
+    Values that change every turn, like the turn counter, are read by the elements themselves and left out.*/
+class GuiKey {
+  public:
+  template <class T>
+  GuiKey& operator << (const T& value) {
+    static_assert(std::is_scalar<T>::value, "Only plain values can be added to a GuiKey directly");
+    key.append((const char*) &value, sizeof(value));
+    return *this;
+  }
+
+  GuiKey& operator << (const string& s) {
+    *this << s.size();
+    key.append(s);
+    return *this;
+  }
+
+  GuiKey& operator << (const ViewObject& object) {
+    return *this << object.getHash();
+  }
+
+  GuiKey& operator << (const Creature* c) {
+    return *this << c->getUniqueId() << c->getName() << c->getSpeciesName() << c->getExpLevel()
+        << c->getViewObject();
+  }
+
+  GuiKey& operator << (const View::GameInfo::BandInfo::Button& button) {
+    *this << button.object << button.name << button.count << button.inactiveReason << button.help
+        << button.hotkey << button.optionsTitle << bool(button.cost);
+    if (button.cost)
+      *this << button.cost->first << button.cost->second;
+    *this << button.options.size();
+    for (auto& option : button.options) {
+      *this << option.text << bool(option.object);
+      if (option.object)
+        *this << *option.object;
+    }
+    return *this;
+  }
+
+  template <class T>
+  GuiKey& operator << (const vector<T>& v) {
+    *this << v.size();
+    for (const T& elem : v)
+      *this << elem;
+    return *this;
+  }
+
+  string key;
+};
+
+void WindowView::updatePanel(GuiPanel& panel, const string& key, Rectangle bounds, function<PGuiElem()> build) {
+  if (panel.key == key)
+    return;
+  panel.key = key;
+  panel.elem = build();
+  if (panel.elem)
+    panel.elem->setBounds(bounds);
+}
+
 void WindowView::rebuildGui() {
-  PGuiElem bottom, right, overMap;
+  rightBarWidth = gameInfo.infoType == GameInfo::InfoType::PLAYER
+      ? rightBarWidthPlayer : rightBarWidthCollective;
+  resetMapBounds();
+  GuiKey common;
+  common << renderer.getWidth() << renderer.getHeight() << tilesOk << gameInfo.infoType;
+  GuiKey right = common, bottom = common, overMap = common;
+  bottom << gameInfo.sunlightInfo.description;
   switch (gameInfo.infoType) {
-    case GameInfo::InfoType::PLAYER:
-        right = drawRightPlayerInfo(gameInfo.playerInfo);
-        bottom = drawBottomPlayerInfo(gameInfo.playerInfo, gameInfo.sunlightInfo);
-        rightBarWidth = rightBarWidthPlayer;
+    case GameInfo::InfoType::PLAYER: {
+        GameInfo::PlayerInfo& info = gameInfo.playerInfo;
+        right << info.weaponName << info.attack << info.attBonus << info.toHit << info.toHitBonus
+            << info.defense << info.defBonus << info.strength << info.strBonus << info.dexterity
+            << info.dexBonus << info.speed << info.speedBonus << info.numGold << info.effects.size();
+        for (auto& effect : info.effects)
+          right << effect.name << effect.bad;
+        bottom << info.title << info.adjectives << info.playerName << info.levelName << info.possessed
+            << info.spellcaster;
         break;
-    case GameInfo::InfoType::BAND:
-        right = drawRightBandInfo(gameInfo.bandInfo, gameInfo.villageInfo);
-        overMap = drawMinionWindow(gameInfo.bandInfo);
-        bottom = drawBottomBandInfo(gameInfo.bandInfo, gameInfo.sunlightInfo);
-        rightBarWidth = rightBarWidthCollective;
+      }
+    case GameInfo::InfoType::BAND: {
+        GameInfo::BandInfo& info = gameInfo.bandInfo;
+        right << collectiveTab << chosenCreature << info.monsterHeader << info.creatures << info.enemies
+            << info.team << info.gatheringTeam << info.buildings << activeBuilding << info.workshop
+            << activeWorkshop << info.libraryButtons << activeLibrary << info.techButtons.size();
+        for (auto& button : info.techButtons)
+          right << button.viewId << button.name << button.hotkey;
+        right << gameInfo.villageInfo.villages.size();
+        for (auto& village : gameInfo.villageInfo.villages)
+          right << village.name << village.tribeName << village.state;
+        bottom << info.warning << myClock.isPaused() << info.numResource.size();
+        for (auto& resource : info.numResource)
+          bottom << resource.viewObject << resource.count << resource.name;
+        overMap << chosenCreature << info.gatheringTeam << info.team << info.creatures << info.tasks.size();
+        for (auto& task : info.tasks)
+          overMap << task.first << task.second;
         break;
+      }
   }
-  resetMapBounds();
-  tempGuiElems.clear();
-  tempGuiElems.push_back(GuiElem::stack(GuiElem::background(GuiElem::background2), 
-        GuiElem::margins(std::move(right), 20, 20, 10, 20)));
-  tempGuiElems.back()->setBounds(Rectangle(
-        renderer.getWidth() - rightBarWidth, 0, renderer.getWidth(), renderer.getHeight()));
-  tempGuiElems.push_back(GuiElem::stack(GuiElem::background(GuiElem::background2),
-        GuiElem::margins(std::move(bottom), 10, 10, 0, 0)));
-  tempGuiElems.back()->setBounds(Rectangle(
-        0, renderer.getHeight() - bottomBarHeight, renderer.getWidth() - rightBarWidth, renderer.getHeight()));
-  if (overMap) {
-    tempGuiElems.push_back(GuiElem::window(GuiElem::stack(GuiElem::background(GuiElem::background2), 
-          GuiElem::margins(std::move(overMap), 20, 20, 20, 20))));
-    tempGuiElems.back()->setBounds(Rectangle(
-          renderer.getWidth() - rightBarWidth - minionWindowWidth - minionWindowRightMargin, 100,
-          renderer.getWidth() - rightBarWidth - minionWindowRightMargin, 100 + minionWindowHeight));
-  }
+  updatePanel(rightPanel, right.key,
+      Rectangle(renderer.getWidth() - rightBarWidth, 0, renderer.getWidth(), renderer.getHeight()),
+      [this] {
+        PGuiElem right = gameInfo.infoType == GameInfo::InfoType::PLAYER
+            ? drawRightPlayerInfo(gameInfo.playerInfo)
+            : drawRightBandInfo(gameInfo.bandInfo, gameInfo.villageInfo);
+        return GuiElem::stack(GuiElem::background(GuiElem::background2), 
+            GuiElem::margins(std::move(right), 20, 20, 10, 20));
+      });
+  updatePanel(bottomPanel, bottom.key,
+      Rectangle(0, renderer.getHeight() - bottomBarHeight, renderer.getWidth() - rightBarWidth,
+          renderer.getHeight()),
+      [this] {
+        PGuiElem bottom = gameInfo.infoType == GameInfo::InfoType::PLAYER
+            ? drawBottomPlayerInfo(gameInfo.playerInfo, gameInfo.sunlightInfo)
+            : drawBottomBandInfo(gameInfo.bandInfo, gameInfo.sunlightInfo);
+        return GuiElem::stack(GuiElem::background(GuiElem::background2),
+            GuiElem::margins(std::move(bottom), 10, 10, 0, 0));
+      });
+  updatePanel(overMapPanel, overMap.key,
+      Rectangle(renderer.getWidth() - rightBarWidth - minionWindowWidth - minionWindowRightMargin, 100,
+          renderer.getWidth() - rightBarWidth - minionWindowRightMargin, 100 + minionWindowHeight),
+      [this] {
+        PGuiElem overMap;
+        if (gameInfo.infoType == GameInfo::InfoType::BAND)
+          overMap = drawMinionWindow(gameInfo.bandInfo);
+        if (!overMap)
+          return PGuiElem();
+        return GuiElem::window(GuiElem::stack(GuiElem::background(GuiElem::background2), 
+            GuiElem::margins(std::move(overMap), 20, 20, 20, 20)));
+      });
+}
+
+vector<GuiElem*> WindowView::getGuiPanels() {
+  vector<GuiElem*> ret;
+  for (GuiPanel* panel : {&rightPanel, &bottomPanel, &overMapPanel})
+    if (panel->elem)
+      ret.push_back(panel->elem.get());
+  return ret;
+}
+
+void WindowView::clearGuiPanels() {
+  for (GuiPanel* panel : {&rightPanel, &bottomPanel, &overMapPanel})
+    *panel = GuiPanel();
 }
 
 vector<GuiElem*> WindowView::getAllGuiElems() {
-  vector<GuiElem*> ret = extractRefs(tempGuiElems);
+  vector<GuiElem*> ret = getGuiPanels();
   if (gameReady)
     ret = concat(concat({mapGui}, ret), {mapDecoration.get(), minimapDecoration.get(), minimapGui});
   return ret;
 }
 
 vector<GuiElem*> WindowView::getClickableGuiElems() {
-  vector<GuiElem*> ret = extractRefs(tempGuiElems);
+  vector<GuiElem*> ret = getGuiPanels();
   ret.push_back(minimapGui);
   ret.push_back(mapGui);
   return ret;
@@ -842,6 +970,7 @@ void WindowView::refreshText() {
 }
 
 void WindowView::resetCenter() {
+  renderThread.wait();
   center = {0, 0};
 }
 
@@ -858,6 +987,7 @@ function<void()> WindowView::getButtonCallback(UserInput input) {
 }
 
 void WindowView::drawLevelMap(const CreatureView* creature) {
+  renderThread.wait();
   TempClockPause pause;
   minimapGui->presentMap(creature, getMapGuiBounds(), renderer,
       [this](double x, double y) { center = {x, y};});
@@ -871,14 +1001,65 @@ void WindowView::updateMinimap(const CreatureView* creature) {
     minimapGui->update(level, bounds, creature);
 }
 
+bool WindowView::TileCacheInfo::operator == (const TileCacheInfo& o) const {
+  return viewer == o.viewer && level == o.level && squareVersion == o.squareVersion
+      && memoryVersion == o.memoryVersion && viewerStamp == o.viewerStamp && visible == o.visible
+      && light == o.light;
+}
+
+WindowView::RefreshStats WindowView::getRefreshStats() const {
+  return refreshStats;
+}
+
+const FrameStats& WindowView::getFrameStats() {
+  renderThread.wait();
+  return frameStats;
+}
+
 void WindowView::refreshViewInt(const CreatureView* collective, bool flipBuffer) {
-  updateMinimap(collective);
+  renderThread.wait();
+  frameStats.startFrame();
+  {
+    FrameStats::Timer timer(frameStats, FramePhase::MINIMAP);
+    updateMinimap(collective);
+  }
+  {
+    FrameStats::Timer timer(frameStats, FramePhase::VIEW_INDEX);
+    updateObjects(collective);
+  }
+  {
+    FrameStats::Timer timer(frameStats, FramePhase::GUI);
+    int numCreated = GuiElem::getNumCreated();
+    rebuildGui();
+    refreshStats.numGuiElems = GuiElem::getNumCreated() - numCreated;
+  }
+  if (flipBuffer) {
+    // The frame is drawn in the background from the view's own state, which is left alone
+    // until renderThread.wait(), so the game can keep simulating in the meantime.
+    renderer.setActive(false);
+    renderThread.draw([this] {
+      renderer.setActive(true);
+      {
+        FrameStats::Timer timer(frameStats, FramePhase::MAP);
+        refreshScreen(false);
+      }
+      {
+        FrameStats::Timer timer(frameStats, FramePhase::FLIP);
+        renderer.drawAndClearBuffer();
+      }
+      renderer.setActive(false);
+    });
+  } else {
+    FrameStats::Timer timer(frameStats, FramePhase::MAP);
+    refreshScreen(false);
+  }
+}
+
+void WindowView::updateObjects(const CreatureView* collective) {
   gameReady = true;
   switchTiles();
   const Level* level = collective->getLevel();
   collective->refreshGameInfo(gameInfo);
-  for (Vec2 pos : mapLayout->getAllTiles(getMapGuiBounds(), Level::getMaxBounds()))
-    objects[pos] = Nothing();
   if ((center.x == 0 && center.y == 0) || collective->staticPosition())
     center = {double(collective->getPosition().x), double(collective->getPosition().y)};
   Vec2 movePos = Vec2((center.x - mouseOffset.x) * mapLayout->squareWidth(),
@@ -889,8 +1070,21 @@ void WindowView::refreshViewInt(const CreatureView* collective, bool flipBuffer)
   movePos.y = min(movePos.y, int(collective->getLevel()->getBounds().getKY() * mapLayout->squareHeight()));
   mapLayout->updatePlayerPos(movePos);
   const MapMemory* memory = &collective->getMemory(); 
+  refreshStats = {0, 0, 0};
+  vector<Vec2> changedTiles;
   for (Vec2 pos : mapLayout->getAllTiles(getMapGuiBounds(), Level::getMaxBounds())) 
     if (level->inBounds(pos)) {
+      const Square* square = level->getSquare(pos);
+      TileCacheInfo info {collective, level, square->getVersion(), memory->getVersion(pos),
+          collective->getViewIndexStamp(pos), collective->canSee(pos), level->getLight(pos)};
+      // a creature's appearance can change without the square noticing, so such tiles are always rebuilt
+      if (!square->getCreature() && tileCache[pos] && *tileCache[pos] == info) {
+        ++refreshStats.numReused;
+        continue;
+      }
+      ++refreshStats.numRebuilt;
+      tileCache[pos] = info;
+      changedTiles.push_back(pos);
       ViewIndex index = collective->getViewIndex(pos);
       if (!index.hasObject(ViewLayer::FLOOR) && !index.hasObject(ViewLayer::FLOOR_BACKGROUND) &&
           !index.isEmpty() && memory->hasViewIndex(pos)) {
@@ -903,16 +1097,21 @@ void WindowView::refreshViewInt(const CreatureView* collective, bool flipBuffer)
       if (index.isEmpty() && memory->hasViewIndex(pos))
         index = memory->getViewIndex(pos);
       objects[pos] = index;
+    } else if (objects[pos]) {
+      objects[pos] = Nothing();
+      tileCache[pos] = Nothing();
+      changedTiles.push_back(pos);
     }
   mapGui->setLayout(mapLayout);
   mapGui->setSpriteMode(currentTileLayout.sprites);
-  mapGui->updateObjects(memory);
+  mapGui->updateObjects(memory, changedTiles);
   mapGui->setLevelBounds(level->getBounds());
-  rebuildGui();
-  refreshScreen(flipBuffer);
 }
 
 void WindowView::animateObject(vector<Vec2> trajectory, ViewObject object) {
+  renderThread.wait();
+  // the object stays at the end of the trajectory until the tile is rebuilt by the next refresh
+  tileCache[trajectory.back()] = Nothing();
   for (Vec2 pos : trajectory) {
     if (!objects[pos])
       continue;
@@ -937,6 +1136,7 @@ void WindowView::animateObject(vector<Vec2> trajectory, ViewObject object) {
 }
 
 void WindowView::animation(Vec2 pos, AnimationId id) {
+  renderThread.wait();
   CHECK(id == AnimationId::EXPLOSION);
   Vec2 wpos = mapLayout->projectOnScreen(getMapGuiBounds(), pos);
   refreshScreen(false);
@@ -1037,6 +1237,7 @@ Optional<int> reverseIndexHeight(const vector<View::ListElem>& options, int heig
 }
 
 Optional<Vec2> WindowView::chooseDirection(const string& message) {
+  renderThread.wait();
   showMessage(message);
   refreshScreen();
   do {
@@ -1092,10 +1293,12 @@ Optional<Vec2> WindowView::chooseDirection(const string& message) {
 }
 
 bool WindowView::yesOrNoPrompt(const string& message) {
+  renderThread.wait();
   return chooseFromList("", {ListElem(message, TITLE), "Yes", "No"}) == 0;
 }
 
 Optional<int> WindowView::getNumber(const string& title, int min, int max, int increments) {
+  renderThread.wait();
   CHECK(min < max);
   vector<View::ListElem> options;
   vector<int> numbers;
@@ -1112,6 +1315,7 @@ Optional<int> WindowView::getNumber(const string& title, int min, int max, int i
 
 Optional<int> WindowView::chooseFromList(const string& title, const vector<ListElem>& options, int index,
     MenuType type, double* scrollPos, Optional<UserInput::Type> exitAction) {
+  renderThread.wait();
   return chooseFromListInternal(title, options, index, type, scrollPos, exitAction, Nothing(), {});
 }
 
@@ -1234,12 +1438,14 @@ static vector<string> breakText(const string& text) {
 }
 
 void WindowView::presentText(const string& title, const string& text) {
+  renderThread.wait();
   TempClockPause pause;
   presentList(title, View::getListElem(breakText(text)), false);
 }
 
 void WindowView::presentList(const string& title, const vector<ListElem>& options, bool scrollDown,
     Optional<UserInput::Type> exitAction) {
+  renderThread.wait();
   vector<ListElem> conv;
   for (ListElem e : options) {
     View::ElemMod mod = e.getMod();
@@ -1311,17 +1517,20 @@ void WindowView::addImportantMessage(const string& message) {
   presentText("", message);
 }
 
-void WindowView::clearMessages() { 
+void WindowView::clearMessages() {
+  renderThread.wait();
   showMessage("");
 }
 
 void WindowView::retireMessages() {
+  renderThread.wait();
   string lastMsg = currentMessage[messageInd];
   showMessage(lastMsg);
   oldMessage = true;
 }
 
 void WindowView::addMessage(const string& message) {
+  renderThread.wait();
   if (oldMessage)
     showMessage("");
   oldMessage = false;
@@ -1532,6 +1741,8 @@ void WindowView::keyboardAction(Event::KeyEvent key) {
 UserInput WindowView::getAction() {
   Event event;
   while (renderer.pollEvent(event)) {
+    // events are polled while the last frame is being drawn, but handling them changes the view
+    renderThread.wait();
     considerScrollEvent(event);
     considerResizeEvent(event, getAllGuiElems());
     propagateEvent(event, getClickableGuiElems());
@@ -22,6 +22,8 @@
 #include "map_gui.h"
 #include "minimap_gui.h"
 #include "input_queue.h"
+#include "render_thread.h"
+#include "frame_stats.h"
 
 class ViewIndex;
 
@@ -66,19 +68,35 @@ class WindowView: public View {
   
   static Color getFireColor();
 
+  struct RefreshStats {
+    int numRebuilt;
+    int numReused;
+    int numGuiElems;
+  };
+
+  /** Returns how many visible map tiles had their ViewIndex rebuilt or reused by the last refresh,
+      and how many GuiElems it created.*/
+  RefreshStats getRefreshStats() const;
+
+  /** Returns the phase timings of the last frames drawn by refreshView and updateView.*/
+  const FrameStats& getFrameStats();
+
   private:
+  friend class RenderBenchmark;
 
   void updateMinimap(const CreatureView*);
+  void setWindowVisible(bool);
   Rectangle getMenuPosition(View::MenuType type);
   Optional<int> chooseFromListInternal(const string& title, const vector<ListElem>& options, int index, MenuType,
       double* scrollPos, Optional<UserInput::Type> exitAction, Optional<sf::Event::KeyEvent> exitKey,
       vector<sf::Event::KeyEvent> shortCuts);
   Optional<UserInput::Type> getSimpleInput(sf::Event::KeyEvent key);
   void refreshViewInt(const CreatureView*, bool flipBuffer = true);
+  void updateObjects(const CreatureView*);
   void rebuildGui();
   void drawMap();
   PGuiElem getSunlightInfoGui(GameInfo::SunlightInfo& sunlightInfo);
-  PGuiElem getTurnInfoGui(int turn);
+  PGuiElem getTurnInfoGui(const double& turn);
   PGuiElem drawBottomPlayerInfo(GameInfo::PlayerInfo&, GameInfo::SunlightInfo&);
   PGuiElem drawRightPlayerInfo(GameInfo::PlayerInfo&);
   PGuiElem drawPlayerStats(GameInfo::PlayerInfo&);
@@ -146,12 +164,38 @@ class WindowView: public View {
 
   Table<Optional<ViewIndex>> objects;
 
+  /** Everything that the ViewIndex of a tile depended on when it was last built.*/
+  struct TileCacheInfo {
+    bool operator == (const TileCacheInfo&) const;
+    const CreatureView* viewer;
+    const Level* level;
+    int squareVersion;
+    int memoryVersion;
+    int viewerStamp;
+    bool visible;
+    double light;
+  };
+  Table<Optional<TileCacheInfo>> tileCache;
+  RefreshStats refreshStats = {0, 0, 0};
+  FrameStats frameStats = FrameStats(1000);
+
   MapLayout* mapLayout;
   MapGui* mapGui;
   MinimapGui* minimapGui;
   PGuiElem mapDecoration;
   PGuiElem minimapDecoration;
-  vector<PGuiElem> tempGuiElems;
+
+  /** A top level part of the GUI, kept between refreshes and rebuilt only when the data it shows changes.*/
+  struct GuiPanel {
+    string key;
+    PGuiElem elem;
+  };
+  GuiPanel rightPanel;
+  GuiPanel bottomPanel;
+  GuiPanel overMapPanel;
+  void updatePanel(GuiPanel&, const string& key, Rectangle bounds, function<PGuiElem()> build);
+  vector<GuiElem*> getGuiPanels();
+  void clearGuiPanels();
   vector<GuiElem*> getAllGuiElems();
   vector<GuiElem*> getClickableGuiElems();
   InputQueue inputQueue;
@@ -180,6 +224,9 @@ class WindowView: public View {
     double x;
     double y;
   } mouseOffset, center;
+
+  /** Draws the frames prepared by refreshView. Declared last, so that it's stopped before the rest is destroyed.*/
+  RenderThread renderThread;
 };
 
 
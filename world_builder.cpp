@@ -0,0 +1,82 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#include "stdafx.h"
+
+#include "world_builder.h"
+#include "level_maker.h"
+#include "creature.h"
+
+int WorldBuilder::addLevel(Level::Builder&& builder, LevelMaker* maker) {
+  tasks.push_back({std::move(builder), maker, Random.split()});
+  return tasks.size() - 1;
+}
+
+void WorldBuilder::addLink(StairDirection dir, StairKey key, int level1, int level2) {
+  links.push_back({dir, key, level1, level2});
+}
+
+const vector<WorldBuilder::Link>& WorldBuilder::getLinks() const {
+  return links;
+}
+
+void WorldBuilder::make(Task& task) {
+  Random = task.random;
+  task.builder.make(task.maker);
+  task.random = Random;
+}
+
+vector<PLevel> WorldBuilder::build(Model* model, int numThreads) {
+  if (numThreads == 0)
+    numThreads = max<int>(1, thread::hardware_concurrency());
+  numThreads = min<int>(numThreads, tasks.size());
+  // The makers check squares against these creatures, which would otherwise be created by whichever
+  // thread got there first.
+  Creature::getDefault();
+  Creature::getDefaultMinion();
+  Creature::getDefaultMinionFlyer();
+  RandomGen random = Random;
+  if (numThreads <= 1) {
+    for (Task& task : tasks)
+      make(task);
+  } else {
+    std::atomic<int> nextTask(0);
+    std::mutex mut;
+    std::exception_ptr exception;
+    vector<thread> threads;
+    for (int i : Range(numThreads))
+      threads.emplace_back([&] {
+        try {
+          for (int index = nextTask++; index < tasks.size(); index = nextTask++)
+            make(tasks[index]);
+        } catch (...) {
+          std::unique_lock<std::mutex> lock(mut);
+          exception = std::current_exception();
+          nextTask = tasks.size();
+        }
+      });
+    for (thread& t : threads)
+      t.join();
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+  vector<PLevel> ret;
+  for (Task& task : tasks) {
+    Random = task.random;
+    ret.push_back(task.builder.build(model));
+  }
+  Random = random;
+  return ret;
+}
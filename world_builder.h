@@ -0,0 +1,62 @@
+/* Copyright (C) 2013-2014 Michal Brzozowski (rusolis@poczta.fm)
+
+   This file is part of KeeperRL.
+
+   KeeperRL is free software; you can redistribute it and/or modify it under the terms of the
+   GNU General Public License as published by the Free Software Foundation; either version 2
+   of the License, or (at your option) any later version.
+
+   KeeperRL is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+   even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License along with this program.
+   If not, see http://www.gnu.org/licenses/ . */
+
+#ifndef _WORLD_BUILDER_H
+#define _WORLD_BUILDER_H
+
+#include "util.h"
+#include "level.h"
+
+class LevelMaker;
+class Model;
+
+/**
+  * Generates a batch of levels, running their makers on worker threads. Every level has its own random
+  * stream, split from Random when the level is added, and the population of the levels is added on the
+  * calling thread in the order they were added, so the result doesn't depend on the number of threads.
+  */
+class WorldBuilder {
+  public:
+  /** Adds a level to the batch and returns its number.*/
+  int addLevel(Level::Builder&&, LevelMaker*);
+
+  /** Adds stairs between two levels of the batch. They are linked once the levels are built.*/
+  void addLink(StairDirection, StairKey, int level1, int level2);
+
+  struct Link {
+    StairDirection direction;
+    StairKey key;
+    int level1;
+    int level2;
+  };
+
+  const vector<Link>& getLinks() const;
+
+  /** Builds all levels of the batch using up to numThreads threads, and returns them in the order they
+      were added. If numThreads is 0, one thread per core is used. Can only be called once.*/
+  vector<PLevel> build(Model*, int numThreads = 0);
+
+  private:
+  struct Task {
+    Level::Builder builder;
+    LevelMaker* maker;
+    RandomGen random;
+  };
+  void make(Task&);
+  vector<Task> tasks;
+  vector<Link> links;
+};
+
+#endif